@@ -0,0 +1,489 @@
+// Instruction-set simulator for the pipelined core: RV32I (no FENCE/CSR)
+// plus the custom CTZ opcode, with an optional per-retirement trace that
+// tracediff.py compares against the testbench's writeback trace.
+//
+//   iss [options] program.dat
+//
+// program.dat is what InstructionMemory.v reads with $readmemb: one byte
+// per line in binary, most significant byte of each instruction first.
+// Execution starts at pc 0 with sp (x2) = 128, as Register.v resets it,
+// and stops at an all-zero word, ECALL/EBREAK, or the instruction limit.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Decoded once per word before the run, so the loop is a single switch
+enum Op : uint8_t {
+    OP_LUI, OP_AUIPC, OP_JAL, OP_JALR,
+    OP_BEQ, OP_BNE, OP_BLT, OP_BGE, OP_BLTU, OP_BGEU,
+    OP_LB, OP_LH, OP_LW, OP_LBU, OP_LHU, OP_SB, OP_SH, OP_SW,
+    OP_ADDI, OP_SLTI, OP_SLTIU, OP_XORI, OP_ORI, OP_ANDI,
+    OP_SLLI, OP_SRLI, OP_SRAI,
+    OP_ADD, OP_SUB, OP_SLL, OP_SLT, OP_SLTU, OP_XOR, OP_SRL, OP_SRA, OP_OR, OP_AND,
+    OP_CTZ,
+    OP_HALT,        // All-zero word, ECALL, EBREAK
+    OP_ILLEGAL,
+};
+
+const char *const op_names[] = {
+    "lui", "auipc", "jal", "jalr",
+    "beq", "bne", "blt", "bge", "bltu", "bgeu",
+    "lb", "lh", "lw", "lbu", "lhu", "sb", "sh", "sw",
+    "addi", "slti", "sltiu", "xori", "ori", "andi",
+    "slli", "srli", "srai",
+    "add", "sub", "sll", "slt", "sltu", "xor", "srl", "sra", "or", "and",
+    "ctz",
+    "halt",
+    "illegal",
+};
+
+constexpr uint32_t OPC_CTZ = 0x4B;      // 7'b1001011, controlnew.v
+
+struct Insn {
+    Op op;
+    uint8_t rd, rs1, rs2;
+    int32_t imm;
+};
+
+int32_t imm_i(uint32_t w) { return int32_t(w) >> 20; }
+int32_t imm_s(uint32_t w) { return (int32_t(w) >> 25 << 5) | ((w >> 7) & 0x1F); }
+int32_t imm_b(uint32_t w) {
+    return (int32_t(w) >> 31 << 12) | ((w << 4) & 0x800) | ((w >> 20) & 0x7E0) | ((w >> 7) & 0x1E);
+}
+int32_t imm_u(uint32_t w) { return int32_t(w & 0xFFFFF000); }
+int32_t imm_j(uint32_t w) {
+    return (int32_t(w) >> 31 << 20) | (w & 0xFF000) | ((w >> 9) & 0x800) | ((w >> 20) & 0x7FE);
+}
+
+Insn decode(uint32_t w) {
+    Insn d{OP_ILLEGAL, uint8_t((w >> 7) & 31), uint8_t((w >> 15) & 31), uint8_t((w >> 20) & 31), 0};
+    uint32_t f3 = (w >> 12) & 7, f7 = w >> 25;
+
+    switch (w & 0x7F) {
+    case 0x37: d.op = OP_LUI; d.imm = imm_u(w); break;
+    case 0x17: d.op = OP_AUIPC; d.imm = imm_u(w); break;
+    case 0x6F: d.op = OP_JAL; d.imm = imm_j(w); break;
+    case 0x67:
+        if (f3 == 0) { d.op = OP_JALR; d.imm = imm_i(w); }
+        break;
+    case 0x63: {
+        static const Op ops[8] = {OP_BEQ, OP_BNE, OP_ILLEGAL, OP_ILLEGAL, OP_BLT, OP_BGE, OP_BLTU, OP_BGEU};
+        d.op = ops[f3];
+        d.imm = imm_b(w);
+        break;
+    }
+    case 0x03: {
+        static const Op ops[8] = {OP_LB, OP_LH, OP_LW, OP_ILLEGAL, OP_LBU, OP_LHU, OP_ILLEGAL, OP_ILLEGAL};
+        d.op = ops[f3];
+        d.imm = imm_i(w);
+        break;
+    }
+    case 0x23: {
+        static const Op ops[8] = {OP_SB, OP_SH, OP_SW, OP_ILLEGAL, OP_ILLEGAL, OP_ILLEGAL, OP_ILLEGAL, OP_ILLEGAL};
+        d.op = ops[f3];
+        d.imm = imm_s(w);
+        break;
+    }
+    case 0x13: {
+        static const Op ops[8] = {OP_ADDI, OP_SLLI, OP_SLTI, OP_SLTIU, OP_XORI, OP_SRLI, OP_ORI, OP_ANDI};
+        d.op = ops[f3];
+        d.imm = imm_i(w);
+        if (f3 == 1 && f7 != 0)
+            d.op = OP_ILLEGAL;
+        else if (f3 == 5 && f7 == 0x20)
+            d.op = OP_SRAI;
+        else if (f3 == 5 && f7 != 0)
+            d.op = OP_ILLEGAL;
+        if (f3 == 1 || f3 == 5)
+            d.imm &= 31;
+        break;
+    }
+    case 0x33: {
+        static const Op ops[8] = {OP_ADD, OP_SLL, OP_SLT, OP_SLTU, OP_XOR, OP_SRL, OP_OR, OP_AND};
+        if (f7 == 0)
+            d.op = ops[f3];
+        else if (f7 == 0x20 && f3 == 0)
+            d.op = OP_SUB;
+        else if (f7 == 0x20 && f3 == 5)
+            d.op = OP_SRA;
+        break;
+    }
+    case 0x73:
+        if ((w & ~0x100000u) == 0x73)   // ECALL, EBREAK
+            d.op = OP_HALT;
+        break;
+    case OPC_CTZ:
+        d.op = OP_CTZ;                  // The RTL ignores funct3/funct7/rs2
+        break;
+    case 0x00:
+        if (w == 0)
+            d.op = OP_HALT;             // Past the program: zeroed memory
+        break;
+    }
+    return d;
+}
+
+std::string disasm(const Insn &d) {
+    char buf[64];
+    const char *n = op_names[d.op];
+
+    switch (d.op) {
+    case OP_LUI: case OP_AUIPC:
+        snprintf(buf, sizeof(buf), "%s x%u, 0x%x", n, d.rd, uint32_t(d.imm) >> 12);
+        break;
+    case OP_JAL:
+        snprintf(buf, sizeof(buf), "%s x%u, %d", n, d.rd, d.imm);
+        break;
+    case OP_JALR: case OP_LB: case OP_LH: case OP_LW: case OP_LBU: case OP_LHU:
+        snprintf(buf, sizeof(buf), "%s x%u, %d(x%u)", n, d.rd, d.imm, d.rs1);
+        break;
+    case OP_SB: case OP_SH: case OP_SW:
+        snprintf(buf, sizeof(buf), "%s x%u, %d(x%u)", n, d.rs2, d.imm, d.rs1);
+        break;
+    case OP_BEQ: case OP_BNE: case OP_BLT: case OP_BGE: case OP_BLTU: case OP_BGEU:
+        snprintf(buf, sizeof(buf), "%s x%u, x%u, %d", n, d.rs1, d.rs2, d.imm);
+        break;
+    case OP_ADDI: case OP_SLTI: case OP_SLTIU: case OP_XORI: case OP_ORI: case OP_ANDI:
+    case OP_SLLI: case OP_SRLI: case OP_SRAI:
+        snprintf(buf, sizeof(buf), "%s x%u, x%u, %d", n, d.rd, d.rs1, d.imm);
+        break;
+    case OP_CTZ:
+        snprintf(buf, sizeof(buf), "%s x%u, x%u", n, d.rd, d.rs1);
+        break;
+    case OP_HALT: case OP_ILLEGAL:
+        snprintf(buf, sizeof(buf), "%s", n);
+        break;
+    default:
+        snprintf(buf, sizeof(buf), "%s x%u, x%u, x%u", n, d.rd, d.rs1, d.rs2);
+        break;
+    }
+    return buf;
+}
+
+// Trace lines, in the format pipeline_tb.v writes:
+//   <pc> x<rd> <value>         register write (never x0)
+//   <pc> mem <addr> <value>    store
+//   <pc> -                     neither (branches, writes to x0)
+// Hex by hand: snprintf would cost more than executing the instruction.
+class TraceWriter {
+public:
+    TraceWriter(FILE *f, bool disasm) : f_(f), disasm_(disasm) {}
+    ~TraceWriter() { flush(); }
+
+    void reg(uint32_t pc, unsigned rd, uint32_t value, const Insn &d) {
+        hex(pc);
+        put(' ');
+        put('x');
+        if (rd >= 10)
+            put('0' + rd / 10);
+        put('0' + rd % 10);
+        put(' ');
+        hex(value);
+        end(d);
+    }
+
+    void store(uint32_t pc, uint32_t addr, uint32_t value, const Insn &d) {
+        hex(pc);
+        text(" mem ");
+        hex(addr);
+        put(' ');
+        hex(value);
+        end(d);
+    }
+
+    void none(uint32_t pc, const Insn &d) {
+        hex(pc);
+        text(" -");
+        end(d);
+    }
+
+    void flush() {
+        fwrite(buf_, 1, len_, f_);
+        len_ = 0;
+    }
+
+private:
+    void put(char c) { buf_[len_++] = c; }
+    void text(const char *s) { while (*s) put(*s++); }
+    void hex(uint32_t v) {
+        for (int shift = 28; shift >= 0; shift -= 4)
+            put("0123456789abcdef"[(v >> shift) & 15]);
+    }
+    void end(const Insn &d) {
+        if (disasm_) {
+            text("  ; ");
+            text(disasm(d).c_str());
+        }
+        put('\n');
+        if (len_ > sizeof(buf_) - 128)
+            flush();
+    }
+
+    FILE *f_;
+    bool disasm_;
+    char buf_[1 << 16];
+    size_t len_ = 0;
+};
+
+enum class Stop { Halt, Limit, Illegal, BadPc, BadAccess };
+
+class Iss {
+public:
+    Iss(const std::vector<uint32_t> &words, uint32_t dmem_bytes, uint32_t sp)
+        : prog_(words.size()), dmem_(dmem_bytes, 0) {
+        for (size_t i = 0; i < words.size(); i++)
+            prog_[i] = decode(words[i]);
+        x_[2] = sp;
+    }
+
+    template <bool Traced>
+    Stop run(uint64_t limit, TraceWriter *tw);
+
+    uint64_t retired() const { return retired_; }
+    uint32_t pc() const { return pc_; }
+    uint32_t reg(unsigned i) const { return x_[i]; }
+
+private:
+    bool in_dmem(uint32_t addr, uint32_t size) const {
+        return addr <= dmem_.size() && size <= dmem_.size() - addr;
+    }
+    uint32_t load(uint32_t addr, uint32_t size) const {
+        uint32_t v = 0;
+        for (uint32_t i = 0; i < size; i++)
+            v |= uint32_t(dmem_[addr + i]) << (8 * i);
+        return v;
+    }
+    void store(uint32_t addr, uint32_t size, uint32_t v) {
+        for (uint32_t i = 0; i < size; i++)
+            dmem_[addr + i] = uint8_t(v >> (8 * i));
+    }
+
+    std::vector<Insn> prog_;
+    std::vector<uint8_t> dmem_;
+    uint32_t x_[32] = {};
+    uint32_t pc_ = 0;
+    uint64_t retired_ = 0;
+};
+
+template <bool Traced>
+Stop Iss::run(uint64_t limit, TraceWriter *tw) {
+    const Insn *prog = prog_.data();
+    const uint32_t nwords = uint32_t(prog_.size());
+    uint32_t *x = x_;
+    uint32_t pc = pc_;
+    uint64_t n = retired_;
+    Stop why = Stop::Limit;
+
+    for (; n < limit; n++) {
+        if ((pc & 3) || (pc >> 2) >= nwords) {
+            // Past the end reads as zero, like InstructionMemory.v
+            why = (pc & 3) ? Stop::BadPc : Stop::Halt;
+            break;
+        }
+        const Insn &d = prog[pc >> 2];
+        const uint32_t a = x[d.rs1], b = x[d.rs2];
+        uint32_t next = pc + 4, v = 0, addr = 0, size = 0;
+        bool wr = true, st = false;
+
+        switch (d.op) {
+        case OP_LUI:   v = d.imm; break;
+        case OP_AUIPC: v = pc + d.imm; break;
+        case OP_JAL:   v = pc + 4; next = pc + d.imm; break;
+        case OP_JALR:  v = pc + 4; next = (a + d.imm) & ~1u; break;
+        case OP_BEQ:   wr = false; if (a == b) next = pc + d.imm; break;
+        case OP_BNE:   wr = false; if (a != b) next = pc + d.imm; break;
+        case OP_BLT:   wr = false; if (int32_t(a) < int32_t(b)) next = pc + d.imm; break;
+        case OP_BGE:   wr = false; if (int32_t(a) >= int32_t(b)) next = pc + d.imm; break;
+        case OP_BLTU:  wr = false; if (a < b) next = pc + d.imm; break;
+        case OP_BGEU:  wr = false; if (a >= b) next = pc + d.imm; break;
+        case OP_LB: case OP_LH: case OP_LW: case OP_LBU: case OP_LHU:
+            addr = a + d.imm;
+            size = (d.op == OP_LW) ? 4 : (d.op == OP_LH || d.op == OP_LHU) ? 2 : 1;
+            if (!in_dmem(addr, size)) {
+                why = Stop::BadAccess;
+                goto out;
+            }
+            v = load(addr, size);
+            if (d.op == OP_LB)
+                v = uint32_t(int32_t(v << 24) >> 24);
+            else if (d.op == OP_LH)
+                v = uint32_t(int32_t(v << 16) >> 16);
+            break;
+        case OP_SB: case OP_SH: case OP_SW:
+            addr = a + d.imm;
+            size = (d.op == OP_SW) ? 4 : (d.op == OP_SH) ? 2 : 1;
+            if (!in_dmem(addr, size)) {
+                why = Stop::BadAccess;
+                goto out;
+            }
+            v = size == 4 ? b : b & ((1u << (8 * size)) - 1);
+            store(addr, size, v);
+            wr = false;
+            st = true;
+            break;
+        case OP_ADDI:  v = a + d.imm; break;
+        case OP_SLTI:  v = int32_t(a) < d.imm; break;
+        case OP_SLTIU: v = a < uint32_t(d.imm); break;
+        case OP_XORI:  v = a ^ d.imm; break;
+        case OP_ORI:   v = a | d.imm; break;
+        case OP_ANDI:  v = a & d.imm; break;
+        case OP_SLLI:  v = a << d.imm; break;
+        case OP_SRLI:  v = a >> d.imm; break;
+        case OP_SRAI:  v = uint32_t(int32_t(a) >> d.imm); break;
+        case OP_ADD:   v = a + b; break;
+        case OP_SUB:   v = a - b; break;
+        case OP_SLL:   v = a << (b & 31); break;
+        case OP_SLT:   v = int32_t(a) < int32_t(b); break;
+        case OP_SLTU:  v = a < b; break;
+        case OP_XOR:   v = a ^ b; break;
+        case OP_SRL:   v = a >> (b & 31); break;
+        case OP_SRA:   v = uint32_t(int32_t(a) >> (b & 31)); break;
+        case OP_OR:    v = a | b; break;
+        case OP_AND:   v = a & b; break;
+        case OP_CTZ:   v = a ? __builtin_ctz(a) : 32; break;
+        case OP_HALT:
+            why = Stop::Halt;
+            goto out;
+        case OP_ILLEGAL:
+            why = Stop::Illegal;
+            goto out;
+        }
+
+        if (wr && d.rd)
+            x[d.rd] = v;
+        if (Traced) {
+            if (st)
+                tw->store(pc, addr, v, d);
+            else if (wr && d.rd)
+                tw->reg(pc, d.rd, v, d);
+            else
+                tw->none(pc, d);
+        }
+        pc = next;
+    }
+out:
+    pc_ = pc;
+    retired_ = n;
+    return why;
+}
+
+// $readmemb format: whitespace-separated binary bytes, // comments; no @
+// address records, which the testbench's files do not use
+bool load_dat(const char *path, std::vector<uint32_t> &words) {
+    std::ifstream in(path);
+    std::string tok;
+    std::vector<uint8_t> bytes;
+
+    if (!in)
+        return false;
+    while (in >> tok) {
+        if (tok.compare(0, 2, "//") == 0) {
+            std::getline(in, tok);
+            continue;
+        }
+        if (tok.find_first_not_of("01_") != std::string::npos) {
+            fprintf(stderr, "iss: %s: bad byte '%s'\n", path, tok.c_str());
+            return false;
+        }
+        uint32_t v = 0;
+        for (char c : tok)
+            if (c != '_')
+                v = (v << 1) | uint32_t(c - '0');
+        bytes.push_back(uint8_t(v));
+    }
+    bytes.resize((bytes.size() + 3) & ~size_t(3), 0);
+    for (size_t i = 0; i < bytes.size(); i += 4)
+        words.push_back(uint32_t(bytes[i]) << 24 | uint32_t(bytes[i + 1]) << 16 |
+                        uint32_t(bytes[i + 2]) << 8 | bytes[i + 3]);
+    return true;
+}
+
+void usage() {
+    fprintf(stderr,
+            "usage: iss [options] program.dat\n"
+            "  -t, --trace FILE    write the retirement trace (- for stdout)\n"
+            "  -d, --disasm        append the disassembly to trace lines\n"
+            "  -n, --max N         stop after N instructions (default 1000000)\n"
+            "  -m, --dmem BYTES    data memory size (default 128, as DataMemory.v)\n"
+            "  -r, --regs          print the registers at the end\n");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const char *trace_path = nullptr, *prog_path = nullptr;
+    uint64_t limit = 1000000;
+    uint32_t dmem = 128;
+    bool want_disasm = false, want_regs = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool has_arg = i + 1 < argc;
+
+        if ((a == "-t" || a == "--trace") && has_arg)
+            trace_path = argv[++i];
+        else if (a == "-d" || a == "--disasm")
+            want_disasm = true;
+        else if ((a == "-n" || a == "--max") && has_arg)
+            limit = strtoull(argv[++i], nullptr, 0);
+        else if ((a == "-m" || a == "--dmem") && has_arg)
+            dmem = uint32_t(strtoul(argv[++i], nullptr, 0));
+        else if (a == "-r" || a == "--regs")
+            want_regs = true;
+        else if (a[0] != '-' && !prog_path)
+            prog_path = argv[i];
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (!prog_path) {
+        usage();
+        return 2;
+    }
+
+    std::vector<uint32_t> words;
+    if (!load_dat(prog_path, words)) {
+        fprintf(stderr, "iss: cannot load %s\n", prog_path);
+        return 2;
+    }
+
+    Iss iss(words, dmem, 128);
+    Stop why;
+    auto t0 = std::chrono::steady_clock::now();
+    if (trace_path) {
+        FILE *f = strcmp(trace_path, "-") ? fopen(trace_path, "w") : stdout;
+        if (!f) {
+            fprintf(stderr, "iss: cannot write %s\n", trace_path);
+            return 2;
+        }
+        {
+            TraceWriter tw(f, want_disasm);
+            why = iss.run<true>(limit, &tw);
+        }
+        if (f != stdout)
+            fclose(f);
+    } else {
+        why = iss.run<false>(limit, nullptr);
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    static const char *const reasons[] = {
+        "halted", "instruction limit", "illegal instruction", "misaligned pc", "data access out of range",
+    };
+    fprintf(stderr, "iss: %s at pc %08x after %llu instructions, %.3f s, %.1f MIPS\n",
+            reasons[int(why)], iss.pc(), (unsigned long long)iss.retired(), secs,
+            secs > 0 ? iss.retired() / secs / 1e6 : 0.0);
+    if (want_regs)
+        for (unsigned i = 0; i < 32; i++)
+            fprintf(stderr, "x%-2u %08x%s", i, iss.reg(i), i % 4 == 3 ? "\n" : "  ");
+    return why == Stop::Halt || why == Stop::Limit ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+"""
+Random test programs for the pipeline, in the $readmemb byte format that
+InstructionMemory.v and the ISS load.
+
+Usage:
+  python3 rvgen.py -n 32 --seed 1 -o random.dat
+
+Instructions are drawn from what the pipeline decodes (controlnew.v):
+R-type ALU operations, ADDI, SLTI, LW, SW, BEQ and CTZ. Loads and stores
+use x0 plus a word-aligned offset inside the 128-byte data memory, and
+branches only jump forward, so every program terminates. The pipeline's
+instruction memory holds 32 instructions; larger programs are for the
+ISS or a larger memory.
+"""
+import argparse
+import random
+
+R_OPS = {  # name: (funct3, funct7)
+    "add": (0, 0x00), "sub": (0, 0x20), "sll": (1, 0x00), "slt": (2, 0x00),
+    "sltu": (3, 0x00), "xor": (4, 0x00), "srl": (5, 0x00), "sra": (5, 0x20),
+    "or": (6, 0x00), "and": (7, 0x00),
+}
+DMEM = 128
+
+
+def r_type(name, rd, rs1, rs2):
+    f3, f7 = R_OPS[name]
+    return f7 << 25 | rs2 << 20 | rs1 << 15 | f3 << 12 | rd << 7 | 0x33
+
+
+def i_type(f3, rd, rs1, imm, opcode=0x13):
+    return (imm & 0xFFF) << 20 | rs1 << 15 | f3 << 12 | rd << 7 | opcode
+
+
+def s_type(rs2, rs1, imm):
+    imm &= 0xFFF
+    return (imm >> 5) << 25 | rs2 << 20 | rs1 << 15 | 2 << 12 | (imm & 31) << 7 | 0x23
+
+
+def b_type(rs1, rs2, off):
+    off &= 0x1FFF
+    return ((off >> 12) & 1) << 31 | ((off >> 5) & 63) << 25 | rs2 << 20 | rs1 << 15 | \
+        ((off >> 1) & 15) << 8 | ((off >> 11) & 1) << 7 | 0x63
+
+
+def ctz(rd, rs1):
+    return rs1 << 15 | rd << 7 | 0x4B
+
+
+def program(n, rng):
+    reg = lambda: rng.randrange(32)
+    words = []
+    for i in range(n):
+        kind = rng.choices(["r", "addi", "slti", "lw", "sw", "beq", "ctz"],
+                           weights=[8, 8, 2, 3, 3, 1, 1])[0]
+        if kind == "r":
+            words.append(r_type(rng.choice(list(R_OPS)), reg(), reg(), reg()))
+        elif kind == "addi":
+            words.append(i_type(0, reg(), reg(), rng.randrange(-2048, 2048)))
+        elif kind == "slti":
+            words.append(i_type(2, reg(), reg(), rng.randrange(-2048, 2048)))
+        elif kind == "lw":
+            words.append(i_type(2, reg(), 0, 4 * rng.randrange(DMEM // 4), opcode=0x03))
+        elif kind == "sw":
+            words.append(s_type(reg(), 0, 4 * rng.randrange(DMEM // 4)))
+        elif kind == "beq" and i + 2 < n:
+            words.append(b_type(reg(), reg(), 4 * rng.randrange(2, min(8, n - i) + 1)))
+        else:
+            words.append(ctz(reg(), reg()))
+    return words
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("-n", type=int, default=32, help="instructions")
+    ap.add_argument("--seed", type=int, default=0)
+    ap.add_argument("-o", "--output", required=True)
+    args = ap.parse_args()
+
+    with open(args.output, "w") as f:
+        for w in program(args.n, random.Random(args.seed)):
+            for shift in (24, 16, 8, 0):
+                f.write("{:08b}\n".format((w >> shift) & 0xFF))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,77 @@
+"""
+Compare the ISS retirement trace with the pipeline's writeback trace.
+
+Usage:
+  python3 tracediff.py iss.trace rtl.trace [--context 4]
+
+Only architectural effects are compared, in program order: register
+writes (x0 excluded) and stores. The ISS also logs instructions without
+either ("<pc> -"), which are skipped; anything after ';' is a comment. The
+pipeline runs for a fixed number of cycles, so effects it logs after the
+ISS halted are reported but are not a mismatch. Exits 1 at the first
+divergence, since everything after it is out of step.
+"""
+import argparse
+import sys
+
+
+def effects(path):
+    out = []
+    with open(path) as f:
+        for lineno, line in enumerate(f, 1):
+            line = line.split(";", 1)[0].split()
+            if len(line) < 2 or line[1] == "-":
+                continue
+            try:
+                pc = int(line[0], 16)
+                if line[1] == "mem":
+                    ev = ("mem", int(line[2], 16), int(line[3], 16))
+                elif line[1].startswith("x"):
+                    rd = int(line[1][1:])
+                    if rd == 0:
+                        continue
+                    ev = ("x%d" % rd, int(line[2], 16))
+                else:
+                    raise ValueError(line[1])
+            except (IndexError, ValueError):
+                sys.exit("%s:%d: cannot parse: %s" % (path, lineno, " ".join(line)))
+            out.append((pc, ev))
+    return out
+
+
+def fmt(e):
+    pc, ev = e
+    if ev[0] == "mem":
+        return "%08x mem[%08x] = %08x" % (pc, ev[1], ev[2])
+    return "%08x %s = %08x" % (pc, ev[0], ev[1])
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("iss")
+    ap.add_argument("rtl")
+    ap.add_argument("--context", type=int, default=4, help="matching effects shown before a divergence")
+    args = ap.parse_args()
+
+    ref, dut = effects(args.iss), effects(args.rtl)
+    for i, (r, d) in enumerate(zip(ref, dut)):
+        if r != d:
+            print("diverged at effect %d of %d:" % (i + 1, len(ref)))
+            for e in ref[max(0, i - args.context):i]:
+                print("      %s" % fmt(e))
+            print("  iss %s" % fmt(r))
+            print("  rtl %s" % fmt(d))
+            return 1
+    if len(dut) < len(ref):
+        print("rtl trace ends after %d of %d effects; next expected: %s"
+              % (len(dut), len(ref), fmt(ref[len(dut)])))
+        return 1
+    print("match: %d effects" % len(ref))
+    if len(dut) > len(ref):
+        print("note: rtl logged %d more after the iss halted, first: %s"
+              % (len(dut) - len(ref), fmt(dut[len(ref)])))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
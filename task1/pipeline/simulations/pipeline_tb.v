@@ -2,6 +2,9 @@
 module tb();
 
     reg clk = 0, rst;
+    integer trace_fd = 0;
+    reg [8*256-1:0] trace_file;
+    integer cycles;
     
     // Generate clock signal with a period of 100 time units (50 high + 50 low)
     always begin
@@ -10,16 +13,41 @@ module tb();
     end
 
     initial begin
+        // +cycles=N: run N clocks after reset (verilator/bench.sh sets it)
+        if (!$value$plusargs("cycles=%d", cycles))
+            cycles = 50;
         rst <= 1'b0;
         #200;
         rst <= 1'b1;
-        #5000;  // Increased time to allow all instructions to execute
+        #(cycles * 100);  // Increased time to allow all instructions to execute
+        if (trace_fd) $fclose(trace_fd);
         $finish;    
     end
 
+    // +novcd: skip the waveform, for timing the simulator itself
     initial begin
-        $dumpfile("dump.vcd");
-        $dumpvars(0);
+        if (!$test$plusargs("novcd")) begin
+            $dumpfile("dump.vcd");
+            $dumpvars(0);
+        end
+    end
+
+    // +trace=FILE: log every architectural effect in the format of the ISS
+    // trace (iss/iss.cpp), for iss/tracediff.py. Sampled at the clock edge
+    // that commits it, so a writeback is logged before a younger store in MEM.
+    // A stage frozen by a D-cache miss commits only on its last cycle
+    initial begin
+        if ($value$plusargs("trace=%s", trace_file))
+            trace_fd = $fopen(trace_file, "w");
+    end
+
+    always @(posedge clk) begin
+        if (rst && trace_fd) begin
+            if (dut.RegWriteW && !dut.StallW && dut.RD_W != 5'h00)
+                $fdisplay(trace_fd, "%08x x%0d %08x", dut.PCPlus4W - 32'd4, dut.RD_W, dut.ResultW);
+            if (dut.MemWriteM && !dut.StallM)
+                $fdisplay(trace_fd, "%08x mem %08x %08x", dut.PCPlus4M - 32'd4, dut.ALU_ResultM, dut.WriteDataM);
+        end
     end
 
     pipelined_riscv dut (.clk(clk), .rst(rst));
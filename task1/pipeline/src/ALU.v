@@ -9,11 +9,13 @@ wire slt, slti;
 assign slt = (A < B) ? 1 : 0;   // SLT (Set Less Than)
 assign slti = ($signed(A) < $signed(B)) ? 1 : 0;  // SLTI (Immediate Version)
 
-function automatic [4:0] count_trailing_zeros(input [31:0] val);
+// Scans from the top so the lowest set bit is the one that sticks; six
+// bits wide so that val == 0 gives 32
+function automatic [5:0] count_trailing_zeros(input [31:0] val);
     integer i;
     begin
         count_trailing_zeros = 32; // Default to 32 if val is 0
-        for (i = 0; i < 32; i = i + 1) begin
+        for (i = 31; i >= 0; i = i - 1) begin
             if (val[i]) begin
                 count_trailing_zeros = i;
             end
@@ -36,7 +38,7 @@ always @(*) begin
         4'b1000: ALUOut = slt;          // SLT
         4'b1001: ALUOut = slti;         // SLTI
         4'b1010: ALUOut = A - B;        // SUB (Branch Comparison)
-        4'b1111: ALUOut = count_trailing_zeros(A); // CTZ operation
+        4'b1111: ALUOut = {26'b0, count_trailing_zeros(A)}; // CTZ operation
         default: ALUOut = 32'b0;        // Default case
     endcase
 end
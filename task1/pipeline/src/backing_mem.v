@@ -0,0 +1,77 @@
+// Backing memory for the caches: a byte array that answers whole lines
+// after a fixed latency. The cache holds req (with we, addr and wline)
+// until ready pulses; a read's line is in rline that cycle. BIG_ENDIAN
+// packs words as InstructionMemory.v does (lowest address most
+// significant), otherwise little-endian as DataMemory.v.
+module backing_mem #(
+    parameter BYTES = 16384,
+    parameter LINE_WORDS = 4,
+    parameter LATENCY = 10,
+    parameter BIG_ENDIAN = 0,
+    parameter INIT_FILE = ""
+)
+(
+    input clk,
+    input rst,
+    input req,
+    input we,
+    input [31:0] addr,
+    input [LINE_WORDS*32-1:0] wline,
+    output reg ready,
+    output reg [LINE_WORDS*32-1:0] rline
+);
+
+    localparam AW = $clog2(BYTES);
+
+    reg [7:0] mem [0:BYTES-1];
+    reg busy;
+    reg [31:0] count;
+
+    integer i;
+    initial begin
+        for (i = 0; i < BYTES; i = i + 1)
+            mem[i] = 8'b0;
+        if (INIT_FILE != "")
+            $readmemb(INIT_FILE, mem);
+    end
+
+    // Byte address of byte b of word w in the requested line
+    function [AW-1:0] byte_addr(input integer w, input integer b);
+        byte_addr = addr[AW-1:0] + 4 * w + (BIG_ENDIAN ? 3 - b : b);
+    endfunction
+
+    integer w;
+    always @(posedge clk) begin
+        if (~rst) begin
+            busy <= 1'b0;
+            ready <= 1'b0;
+        end
+        else begin
+            ready <= 1'b0;
+            if (!busy && req && !ready) begin   // ready: the last request is still up
+                busy <= 1'b1;
+                count <= LATENCY - 1;
+            end
+            else if (busy) begin
+                if (count == 0) begin
+                    busy <= 1'b0;
+                    ready <= 1'b1;
+                    for (w = 0; w < LINE_WORDS; w = w + 1) begin
+                        if (we) begin
+                            mem[byte_addr(w, 0)] <= wline[w*32 +: 8];
+                            mem[byte_addr(w, 1)] <= wline[w*32 + 8 +: 8];
+                            mem[byte_addr(w, 2)] <= wline[w*32 + 16 +: 8];
+                            mem[byte_addr(w, 3)] <= wline[w*32 + 24 +: 8];
+                        end
+                        else
+                            rline[w*32 +: 32] <= {mem[byte_addr(w, 3)], mem[byte_addr(w, 2)],
+                                                  mem[byte_addr(w, 1)], mem[byte_addr(w, 0)]};
+                    end
+                end
+                else
+                    count <= count - 1;
+            end
+        end
+    end
+
+endmodule
@@ -0,0 +1,74 @@
+// Branch target buffer: direct-mapped on the word address, one 2-bit
+// saturating counter per entry. Looked up with the fetch PC; a hit whose
+// counter is 2 or 3 predicts taken to the stored target. Branches update
+// it as they resolve in EX, and JALs as decode redirects fetch for them.
+module btb #(
+    parameter ENTRIES = 16
+)
+(
+    input clk,
+    input rst,
+    input [31:0] pc,
+    output taken,
+    output [31:0] target,
+    // Branch resolved in EX
+    input updateE,
+    input [31:0] pcE,
+    input takenE,
+    input [31:0] targetE,
+    // JAL redirected from decode: always taken
+    input updateD,
+    input [31:0] pcD,
+    input [31:0] targetD
+);
+
+    localparam IDX = $clog2(ENTRIES);
+
+    reg valid [0:ENTRIES-1];
+    reg [31:IDX+2] tags [0:ENTRIES-1];
+    reg [31:0] targets [0:ENTRIES-1];
+    reg [1:0] counters [0:ENTRIES-1];
+
+    wire [IDX-1:0] idx = pc[IDX+1:2];
+    wire [IDX-1:0] idxE = pcE[IDX+1:2];
+    wire [IDX-1:0] idxD = pcD[IDX+1:2];
+    wire hitE = valid[idxE] && (tags[idxE] == pcE[31:IDX+2]);
+
+    assign taken = valid[idx] && (tags[idx] == pc[31:IDX+2]) && counters[idx][1];
+    assign target = targets[idx];
+
+    integer i;
+    always @(posedge clk) begin
+        if (~rst) begin
+            for (i = 0; i < ENTRIES; i = i + 1)
+                valid[i] <= 1'b0;
+        end
+        else begin
+            if (updateD) begin
+                valid[idxD] <= 1'b1;
+                tags[idxD] <= pcD[31:IDX+2];
+                targets[idxD] <= targetD;
+                counters[idxD] <= 2'b11;
+            end
+            // Written second so it wins if both land on one entry
+            if (updateE) begin
+                if (hitE) begin
+                    if (takenE) begin
+                        targets[idxE] <= targetE;
+                        if (counters[idxE] != 2'b11)
+                            counters[idxE] <= counters[idxE] + 2'b01;
+                    end
+                    else if (counters[idxE] != 2'b00)
+                        counters[idxE] <= counters[idxE] - 2'b01;
+                end
+                else if (takenE) begin  // Allocate weakly taken
+                    valid[idxE] <= 1'b1;
+                    tags[idxE] <= pcE[31:IDX+2];
+                    targets[idxE] <= targetE;
+                    counters[idxE] <= 2'b10;
+                end
+            end
+        end
+    end
+
+endmodule
@@ -2,7 +2,7 @@ module controlnew(
     input [6:0] opcode,
     input [6:0] funct7,   // funct7 is 7-bit
     input [2:0] funct3,
-    output reg branch, memRead, memtoReg, memWrite, ALUSrc, regWrite,
+    output reg branch, jump, memRead, memtoReg, memWrite, ALUSrc, regWrite, csrRead,
     output reg [3:0] ALUCtl
 );
 
@@ -11,7 +11,7 @@ module controlnew(
     reg ctz ;
     always @(*) begin
         // Default values
-        {branch, memRead, memtoReg, memWrite, ALUSrc, regWrite, ctz, ALUOp} = 9'b000000000;
+        {branch, jump, memRead, memtoReg, memWrite, ALUSrc, regWrite, csrRead, ctz, ALUOp} = 11'b00000000000;
 
         case (opcode)
             7'b0110011: begin  // R-type
@@ -39,10 +39,20 @@ module controlnew(
                 branch = 1;
                 ALUOp = 2'b01;
             end
+            7'b1101111: begin  // JAL: target resolved in decode, rd = pc + 4
+                regWrite = 1;
+                jump = 1;
+            end
             7'b1001011: begin  // Custom instruction (CTZ)
                 regWrite = 1;
                 ctz = 1;
-                ALUCtl = 4'b1111;  // Directly set ALUCtl
+                ALUOp = 2'b11;     // Decoded to ALUCtl 4'b1111 below
+            end
+            7'b1110011: begin  // SYSTEM: CSR reads of the counters (ECALL/EBREAK do nothing)
+                if (funct3 != 3'b000) begin
+                    regWrite = 1;
+                    csrRead = 1;
+                end
             end
         endcase
     end
@@ -50,8 +60,8 @@ module controlnew(
     always @(*) begin
         case (ALUOp)
             2'b00: begin  // Load, Store, ADDI
-                if (funct3 == 3'b000)
-                    ALUCtl = 4'b0000; // ADD
+                if (funct3 == 3'b000 || memRead || memWrite)
+                    ALUCtl = 4'b0000; // ADD (addresses are rs1 + imm whatever the width)
                 else if (funct3 == 3'b010)
                     ALUCtl = 4'b1001; // SLTI
                 else
@@ -76,7 +86,7 @@ module controlnew(
                 endcase
             end
 
-            default: ALUCtl = 4'b1111; // Default (NOP)
+            default: ALUCtl = 4'b1111; // CTZ (ALUOp 2'b11)
         endcase
     end
 
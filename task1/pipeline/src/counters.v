@@ -0,0 +1,89 @@
+// Performance counters, read with csrr (CSRRS rd, csr, x0) as the
+// instruction passes EX. 64 bits each; the machine (0xB..) and user
+// (0xC..) addresses both read them, the "h" variants the upper half.
+// Writes are ignored. A cache access counts once, when it completes, as a
+// miss if a line fill was started for it and as a hit otherwise. A fetch
+// abandoned by a redirect does not count, nor does its fill.
+module perf_counters(clk, rst, RetireW, LoadStall, Mispredict, JumpRedirect, IAccess, IFill, DAccess, DFill, CsrAddr, CsrData);
+
+    // Declaration of I/Os
+    input clk, rst, RetireW, LoadStall, Mispredict, JumpRedirect;
+    input IAccess, IFill, DAccess, DFill;
+    input [11:0] CsrAddr;
+    output reg [31:0] CsrData;
+
+    // Declaration of Registers
+    reg [63:0] cycles, instret, load_stalls, mispredicts, jump_redirects;
+    reg [63:0] icache_hits, icache_misses, dcache_hits, dcache_misses;
+    reg i_filled, d_filled;     // The pending access has missed
+
+    always @(posedge clk or negedge rst) begin
+        if (rst == 1'b0) begin
+            cycles <= 64'd0;
+            instret <= 64'd0;
+            load_stalls <= 64'd0;
+            mispredicts <= 64'd0;
+            jump_redirects <= 64'd0;
+            icache_hits <= 64'd0;
+            icache_misses <= 64'd0;
+            dcache_hits <= 64'd0;
+            dcache_misses <= 64'd0;
+            i_filled <= 1'b0;
+            d_filled <= 1'b0;
+        end
+        else begin
+            cycles <= cycles + 64'd1;
+            instret <= instret + RetireW;
+            load_stalls <= load_stalls + LoadStall;
+            mispredicts <= mispredicts + Mispredict;
+            jump_redirects <= jump_redirects + JumpRedirect;
+
+            if (IAccess) begin
+                if (i_filled | IFill)
+                    icache_misses <= icache_misses + 64'd1;
+                else
+                    icache_hits <= icache_hits + 64'd1;
+                i_filled <= 1'b0;
+            end
+            else if (Mispredict | JumpRedirect)
+                i_filled <= 1'b0;
+            else if (IFill)
+                i_filled <= 1'b1;
+
+            if (DAccess) begin
+                if (d_filled | DFill)
+                    dcache_misses <= dcache_misses + 64'd1;
+                else
+                    dcache_hits <= dcache_hits + 64'd1;
+                d_filled <= 1'b0;
+            end
+            else if (DFill)
+                d_filled <= 1'b1;
+        end
+    end
+
+    always @(*) begin
+        case (CsrAddr)
+            12'hB00, 12'hC00: CsrData = cycles[31:0];           // mcycle, cycle
+            12'hB80, 12'hC80: CsrData = cycles[63:32];
+            12'hB02, 12'hC02: CsrData = instret[31:0];          // minstret, instret
+            12'hB82, 12'hC82: CsrData = instret[63:32];
+            12'hB03, 12'hC03: CsrData = load_stalls[31:0];      // mhpmcounter3: load-use stall cycles
+            12'hB83, 12'hC83: CsrData = load_stalls[63:32];
+            12'hB04, 12'hC04: CsrData = mispredicts[31:0];      // mhpmcounter4: branch mispredictions (2 cycles each)
+            12'hB84, 12'hC84: CsrData = mispredicts[63:32];
+            12'hB05, 12'hC05: CsrData = jump_redirects[31:0];   // mhpmcounter5: decode redirects for JAL (1 cycle each)
+            12'hB85, 12'hC85: CsrData = jump_redirects[63:32];
+            12'hB06, 12'hC06: CsrData = icache_hits[31:0];      // mhpmcounter6-9: cache hits and misses
+            12'hB86, 12'hC86: CsrData = icache_hits[63:32];
+            12'hB07, 12'hC07: CsrData = icache_misses[31:0];
+            12'hB87, 12'hC87: CsrData = icache_misses[63:32];
+            12'hB08, 12'hC08: CsrData = dcache_hits[31:0];
+            12'hB88, 12'hC88: CsrData = dcache_hits[63:32];
+            12'hB09, 12'hC09: CsrData = dcache_misses[31:0];
+            12'hB89, 12'hC89: CsrData = dcache_misses[63:32];
+            default: CsrData = 32'h00000000;
+        endcase
+    end
+
+endmodule
@@ -0,0 +1,118 @@
+// Data cache: WAYS (1 or 2) x SETS lines of LINE_WORDS words, write-back
+// and write-allocate, in front of backing_mem. Accesses are whole aligned
+// words. On a miss the victim line is written back first if it is dirty,
+// then the missing line is read; miss holds the whole pipeline until the
+// access hits, and a store writes the line on that hitting cycle.
+module dcache #(
+    parameter WAYS = 2,
+    parameter SETS = 8,
+    parameter LINE_WORDS = 4
+)
+(
+    input clk,
+    input rst,
+    input re,
+    input we,
+    input [31:0] addr,
+    input [31:0] wdata,
+    output [31:0] rdata,
+    output miss,
+    output fill,                // A miss starts being served: one per miss
+    // Backing memory
+    output reg mem_req,
+    output reg mem_we,
+    output reg [31:0] mem_addr,
+    output reg [LINE_WORDS*32-1:0] mem_wline,
+    input mem_ready,
+    input [LINE_WORDS*32-1:0] mem_rline
+);
+
+    localparam OFF = $clog2(LINE_WORDS * 4);
+    localparam IDX = $clog2(SETS);
+    localparam TAG = 32 - OFF - IDX;
+    localparam WORD = LINE_WORDS > 1 ? OFF - 2 : 1;    // Word-in-line bits
+
+    // Way w of set s is entry w*SETS + s
+    reg valid [0:WAYS*SETS-1];
+    reg dirty [0:WAYS*SETS-1];
+    reg [TAG-1:0] tags [0:WAYS*SETS-1];
+    reg [LINE_WORDS*32-1:0] lines [0:WAYS*SETS-1];
+    reg lru [0:SETS-1];         // Way to replace next
+
+    wire [IDX-1:0] set = addr[OFF+IDX-1:OFF];
+    wire [TAG-1:0] tag = addr[31:OFF+IDX];
+    wire [WORD-1:0] word;
+    wire hit0 = valid[set] && (tags[set] == tag);
+    wire hit1 = (WAYS == 2) && valid[SETS + set] && (tags[SETS + set] == tag);
+    wire hit_way = hit1;
+    wire [31:0] hit_entry = hit_way*SETS + set;
+
+    // A one-word line has no word field to select
+    generate
+        if (LINE_WORDS > 1) begin : g_word
+            assign word = addr[OFF-1:2];
+        end
+        else begin : g_word
+            assign word = 1'b0;
+        end
+    endgenerate
+
+    // Victim for the current address: an invalid way, else the LRU one
+    wire victim_way = (WAYS == 2) && (valid[set] ? (valid[SETS + set] ? lru[set] : 1'b1) : 1'b0);
+    wire [31:0] victim = victim_way*SETS + set;
+
+    assign rdata = lines[hit_entry][word*32 +: 32];
+    assign miss = (re || we) && !(hit0 || hit1);
+    assign fill = miss && !mem_req;
+
+    integer i;
+    always @(posedge clk) begin
+        if (~rst) begin
+            for (i = 0; i < WAYS*SETS; i = i + 1) begin
+                valid[i] <= 1'b0;
+                dirty[i] <= 1'b0;
+            end
+            for (i = 0; i < SETS; i = i + 1)
+                lru[i] <= 1'b0;
+            mem_req <= 1'b0;
+            mem_we <= 1'b0;
+        end
+        else if (mem_req) begin
+            if (mem_ready && mem_we) begin          // Victim written back: now read
+                mem_we <= 1'b0;
+                mem_addr <= {addr[31:OFF], {OFF{1'b0}}};
+                dirty[victim] <= 1'b0;
+                valid[victim] <= 1'b0;
+            end
+            else if (mem_ready) begin
+                valid[victim] <= 1'b1;
+                dirty[victim] <= 1'b0;
+                tags[victim] <= tag;
+                lines[victim] <= mem_rline;
+                lru[set] <= !victim_way;
+                mem_req <= 1'b0;
+            end
+        end
+        else if (miss) begin
+            mem_req <= 1'b1;
+            if (valid[victim] && dirty[victim]) begin
+                mem_we <= 1'b1;
+                mem_addr <= {tags[victim], set, {OFF{1'b0}}};
+                mem_wline <= lines[victim];
+            end
+            else begin
+                mem_we <= 1'b0;
+                mem_addr <= {addr[31:OFF], {OFF{1'b0}}};
+            end
+        end
+        else if (re || we) begin
+            if (we) begin
+                lines[hit_entry][word*32 +: 32] <= wdata;
+                dirty[hit_entry] <= 1'b1;
+            end
+            if (WAYS == 2)
+                lru[set] <= !hit_way;
+        end
+    end
+
+endmodule
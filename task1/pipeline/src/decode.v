@@ -4,26 +4,29 @@
 `include "ImmGen.v"
 module decode_cycle(
     input clk, rst, RegWriteW,
+    input StallE, FlushE, ForwardAD, ForwardBD, ValidD,
     input [4:0] RDW,
-    input [31:0] InstrD, PCD, PCPlus4D, ResultW,
-    output RegWriteE, ALUSrcE, MemWriteE, MemReadE, ResultSrcE, BranchE,
+    input [31:0] InstrD, PCD, PCPlus4D, PredPCD, ResultW,
+    output MispredictD,
+    output [31:0] RedirectPCD,
+    output RegWriteE, ALUSrcE, MemWriteE, MemReadE, ResultSrcE, BranchE, JumpE, CsrE, ValidE,
     output [3:0] ALUControlE,
     output [31:0] RD1_E, RD2_E, Imm_Ext_E,
     output [4:0] RS1_E, RS2_E, RD_E,
-    output [31:0] PCE, PCPlus4E
+    output [31:0] PCE, PCPlus4E, PredPCE
 );
 
     // Declare Interim Wires
-    wire RegWriteD, ALUSrcD, MemWriteD, MemReadD, ResultSrcD, BranchD;
+    wire RegWriteD, ALUSrcD, MemWriteD, MemReadD, ResultSrcD, BranchD, JumpD, CsrD;
     wire [3:0] ALUControlD;
-    wire [31:0] RD1_D, RD2_D, Imm_Ext_D;
+    wire [31:0] RF1_D, RF2_D, RD1_D, RD2_D, Imm_Ext_D, JumpTargetD;
 
     // Declaration of Interim Registers
-    reg RegWriteD_r, ALUSrcD_r, MemWriteD_r, MemReadD_r, ResultSrcD_r, BranchD_r;
+    reg RegWriteD_r, ALUSrcD_r, MemWriteD_r, MemReadD_r, ResultSrcD_r, BranchD_r, JumpD_r, CsrD_r, ValidD_r;
     reg [3:0] ALUControlD_r;
     reg [31:0] RD1_D_r, RD2_D_r, Imm_Ext_D_r;
     reg [4:0] RD_D_r, RS1_D_r, RS2_D_r;
-    reg [31:0] PCD_r, PCPlus4D_r;
+    reg [31:0] PCD_r, PCPlus4D_r, PredPCD_r;
 
     // Control Unit
     controlnew control (
@@ -31,11 +34,13 @@ module decode_cycle(
         .funct3(InstrD[14:12]), 
         .funct7(InstrD[31:25]), 
         .branch(BranchD), 
+        .jump(JumpD),
         .memRead(MemReadD),  // ✅ **Fixed: Added memRead for Load instructions**
         .memtoReg(ResultSrcD), 
         .memWrite(MemWriteD), 
         .ALUSrc(ALUSrcD), 
         .regWrite(RegWriteD), 
+        .csrRead(CsrD),
         .ALUCtl(ALUControlD)
     );
 
@@ -48,8 +53,23 @@ module decode_cycle(
         .readReg2(InstrD[24:20]),
         .writeReg(RDW),
         .writeData(ResultW),
-        .readData1(RD1_D),
-        .readData2(RD2_D)
+        .readData1(RF1_D),
+        .readData2(RF2_D)
+    );
+
+    // Writeback bypass for the register file reads
+    Mux2to1 #(.size(32)) m_Mux_RD1(
+        .sel(ForwardAD),
+        .s0(RF1_D),
+        .s1(ResultW),
+        .out(RD1_D)
+    );
+
+    Mux2to1 #(.size(32)) m_Mux_RD2(
+        .sel(ForwardBD),
+        .s0(RF2_D),
+        .s1(ResultW),
+        .out(RD2_D)
     );
 
     // Sign Extension
@@ -58,6 +78,24 @@ module decode_cycle(
         .imm(Imm_Ext_D)
     );
 
+    // JAL Target Adder
+    Adder jump_adder (
+        .a(PCD),
+        .b(Imm_Ext_D),
+        .sum(JumpTargetD)
+    );
+
+    // Fetch's guess is checked here for everything but branches, which
+    // resolve in EX: a JAL goes to its target, the rest fall through
+    Mux2to1 #(.size(32)) m_Mux_NextPC(
+        .sel(JumpD),
+        .s0(PCPlus4D),
+        .s1(JumpTargetD),
+        .out(RedirectPCD)
+    );
+
+    assign MispredictD = ValidD & ~BranchD & (RedirectPCD != PredPCD);
+
     // Register Logic
     always @(posedge clk or negedge rst) begin
         if (!rst) begin
@@ -67,6 +105,29 @@ module decode_cycle(
             MemReadD_r <= 1'b0;  // ✅ **Fixed: Added MemReadD_r**
             ResultSrcD_r <= 1'b0;
             BranchD_r <= 1'b0;
+            JumpD_r <= 1'b0;
+            CsrD_r <= 1'b0;
+            ValidD_r <= 1'b0;
+            ALUControlD_r <= 3'b000;
+            RD1_D_r <= 32'h00000000;
+            RD2_D_r <= 32'h00000000;
+            Imm_Ext_D_r <= 32'h00000000;
+            RD_D_r <= 5'h00;
+            PCD_r <= 32'h00000000;
+            PCPlus4D_r <= 32'h00000000;
+            PredPCD_r <= 32'h00000000;
+            RS1_D_r <= 5'h00;
+            RS2_D_r <= 5'h00;
+        end else if (FlushE) begin  // Bubble: load-use stall or taken branch
+            RegWriteD_r <= 1'b0;
+            ALUSrcD_r <= 1'b0;
+            MemWriteD_r <= 1'b0;
+            MemReadD_r <= 1'b0;
+            ResultSrcD_r <= 1'b0;
+            BranchD_r <= 1'b0;
+            JumpD_r <= 1'b0;
+            CsrD_r <= 1'b0;
+            ValidD_r <= 1'b0;
             ALUControlD_r <= 3'b000;
             RD1_D_r <= 32'h00000000;
             RD2_D_r <= 32'h00000000;
@@ -74,15 +135,19 @@ module decode_cycle(
             RD_D_r <= 5'h00;
             PCD_r <= 32'h00000000;
             PCPlus4D_r <= 32'h00000000;
+            PredPCD_r <= 32'h00000000;
             RS1_D_r <= 5'h00;
             RS2_D_r <= 5'h00;
-        end else begin
+        end else if (!StallE) begin
             RegWriteD_r <= RegWriteD;
             ALUSrcD_r <= ALUSrcD;
             MemWriteD_r <= MemWriteD;
             MemReadD_r <= MemReadD;  // ✅ **Fixed: Store MemReadD**
             ResultSrcD_r <= ResultSrcD;
             BranchD_r <= BranchD;
+            JumpD_r <= JumpD;
+            CsrD_r <= CsrD;
+            ValidD_r <= ValidD;
             ALUControlD_r <= ALUControlD;
             RD1_D_r <= RD1_D;
             RD2_D_r <= RD2_D;
@@ -90,6 +155,7 @@ module decode_cycle(
             RD_D_r <= InstrD[11:7];
             PCD_r <= PCD;
             PCPlus4D_r <= PCPlus4D;
+            PredPCD_r <= PredPCD;
             RS1_D_r <= InstrD[19:15];
             RS2_D_r <= InstrD[24:20];
         end
@@ -102,6 +168,9 @@ module decode_cycle(
     assign MemReadE = MemReadD_r;  // ✅ **Fixed: Forward MemReadE**
     assign ResultSrcE = ResultSrcD_r;
     assign BranchE = BranchD_r;
+    assign JumpE = JumpD_r;
+    assign CsrE = CsrD_r;
+    assign ValidE = ValidD_r;
     assign ALUControlE = ALUControlD_r;
     assign RD1_E = RD1_D_r;
     assign RD2_E = RD2_D_r;
@@ -109,6 +178,7 @@ module decode_cycle(
     assign RD_E = RD_D_r;
     assign PCE = PCD_r;
     assign PCPlus4E = PCPlus4D_r;
+    assign PredPCE = PredPCD_r;
     assign RS1_E = RS1_D_r;
     assign RS2_E = RS2_D_r;
 
@@ -3,10 +3,12 @@
 // `include "Mux2to1.v"
 // `include "Adder.v"
 module execute_cycle(clk, rst, RegWriteE, ALUSrcE, MemWriteE, MemReadE, ResultSrcE, BranchE, ALUControlE, 
-    RD1_E, RD2_E, Imm_Ext_E, RD_E, PCE, PCPlus4E, PCSrcE, PCTargetE, RegWriteM, MemWriteM, MemReadM, ResultSrcM, RD_M, PCPlus4M, WriteDataM, ALU_ResultM, ResultW, ForwardA_E, ForwardB_E);
+    RD1_E, RD2_E, Imm_Ext_E, RD_E, PCE, PCPlus4E, PCSrcE, PCTargetE, RegWriteM, MemWriteM, MemReadM, ResultSrcM, RD_M, PCPlus4M, WriteDataM, ALU_ResultM, ResultW, ForwardA_E, ForwardB_E,
+    CsrE, CsrDataE, ValidE, ValidM, JumpE, PredPCE, MispredictE, RedirectPCE, StallM);
 
     // Declaration I/Os
-    input clk, rst, RegWriteE, ALUSrcE, MemWriteE, MemReadE, ResultSrcE, BranchE;
+    input clk, rst, RegWriteE, ALUSrcE, MemWriteE, MemReadE, ResultSrcE, BranchE, CsrE, ValidE, JumpE, StallM;
+    input [31:0] CsrDataE, PredPCE;
     input [3:0] ALUControlE;
     input [31:0] RD1_E, RD2_E, Imm_Ext_E;
     input [4:0] RD_E;
@@ -14,18 +16,18 @@ module execute_cycle(clk, rst, RegWriteE, ALUSrcE, MemWriteE, MemReadE, ResultSr
     input [31:0] ResultW;
     input [1:0] ForwardA_E, ForwardB_E;
 
-    output PCSrcE, RegWriteM, MemWriteM, MemReadM, ResultSrcM;
+    output PCSrcE, RegWriteM, MemWriteM, MemReadM, ResultSrcM, ValidM, MispredictE;
     output [4:0] RD_M; 
     output [31:0] PCPlus4M, WriteDataM, ALU_ResultM;
-    output [31:0] PCTargetE;
+    output [31:0] PCTargetE, RedirectPCE;
 
     // Declaration of Interim Wires
     wire [31:0] Src_A, Src_B_interim, Src_B;
-    wire [31:0] ResultE;
+    wire [31:0] ALUOutE, CsrOutE, ResultE;
     wire ZeroE;
 
     // Declaration of Register
-    reg RegWriteE_r, MemWriteE_r, MemReadE_r, ResultSrcE_r;
+    reg RegWriteE_r, MemWriteE_r, MemReadE_r, ResultSrcE_r, ValidE_r;
     reg [4:0] RD_E_r;
     reg [31:0] PCPlus4E_r, RD2_E_r, ResultE_r;
 
@@ -59,11 +61,27 @@ module execute_cycle(clk, rst, RegWriteE, ALUSrcE, MemWriteE, MemReadE, ResultSr
     ALU alu (
             .A(Src_A),
             .B(Src_B),
-            .ALUOut(ResultE),
+            .ALUOut(ALUOutE),
             .ALUCtl(ALUControlE),
             .zero(ZeroE)
             );
 
+    // CSR read result in place of the ALU's
+    Mux2to1 #(.size(32)) m_Mux_Csr(
+          .sel(CsrE),
+           .s0(ALUOutE),
+           .s1(CsrDataE),
+             .out(CsrOutE)
+);
+
+    // JAL links pc + 4
+    Mux2to1 #(.size(32)) m_Mux_Link(
+          .sel(JumpE),
+           .s0(CsrOutE),
+           .s1(PCPlus4E),
+             .out(ResultE)
+);
+
     // Adder
     Adder branch_adder (
             .a(PCE),
@@ -71,6 +89,16 @@ module execute_cycle(clk, rst, RegWriteE, ALUSrcE, MemWriteE, MemReadE, ResultSr
             .sum(PCTargetE)
             );
 
+    // Where a branch really goes, against where fetch guessed it would
+    Mux2to1 #(.size(32)) m_Mux_Resolve(
+          .sel(PCSrcE),
+           .s0(PCPlus4E),
+           .s1(PCTargetE),
+             .out(RedirectPCE)
+);
+
+    assign MispredictE = BranchE & (RedirectPCE != PredPCE);
+
     // Register Logic
     always @(posedge clk or negedge rst) begin
         if(rst == 1'b0) begin
@@ -78,16 +106,18 @@ module execute_cycle(clk, rst, RegWriteE, ALUSrcE, MemWriteE, MemReadE, ResultSr
             MemWriteE_r <= 1'b0; 
             MemReadE_r <= 1'b0;
             ResultSrcE_r <= 1'b0;
+            ValidE_r <= 1'b0;
             RD_E_r <= 5'h00;
             PCPlus4E_r <= 32'h00000000; 
             RD2_E_r <= 32'h00000000; 
             ResultE_r <= 32'h00000000;
         end
-        else begin
+        else if (!StallM) begin
             RegWriteE_r <= RegWriteE; 
             MemWriteE_r <= MemWriteE; 
             MemReadE_r <= MemReadE;
             ResultSrcE_r <= ResultSrcE;
+            ValidE_r <= ValidE;
             RD_E_r <= RD_E;
             PCPlus4E_r <= PCPlus4E; 
             RD2_E_r <= Src_B_interim; 
@@ -101,6 +131,7 @@ module execute_cycle(clk, rst, RegWriteE, ALUSrcE, MemWriteE, MemReadE, ResultSr
     assign MemWriteM = MemWriteE_r;
     assign MemReadM = MemReadE_r;
     assign ResultSrcM = ResultSrcE_r;
+    assign ValidM = ValidE_r;
     assign RD_M = RD_E_r;
     assign PCPlus4M = PCPlus4E_r;
     assign WriteDataM = RD2_E_r;
@@ -2,30 +2,96 @@
 // `include "Adder.v"
 `include "InstructionMemory.v"
 // `include "Mux2to1.v"
+`include "btb.v"
+`ifdef CACHES
+`include "icache.v"
+// `include "backing_mem.v"
+`endif
 
-module fetch_cycle(clk, rst, branchMuxSel, branchTarget, InstrD, PCD, PCPlus4D);
+module fetch_cycle(clk, rst, redirectE, redirectPCE, redirectD, redirectPCD, updateBtbE, branchPCE, branchTakenE, branchTargetE,
+    StallF, StallD, FlushD, InstrD, PCD, PCPlus4D, PredPCD, ValidD, IMiss, IFill);
+
+    // Cache geometry and backing memory, for CACHES builds (see icache.v)
+    parameter ICACHE_WAYS = 1;
+    parameter ICACHE_SETS = 16;
+    parameter LINE_WORDS = 4;
+    parameter MEM_BYTES = 16384;
+    parameter MEM_LATENCY = 10;
 
     // Declare inputs & outputs
     input clk, rst;
-    input branchMuxSel;
-    input [31:0] branchTarget;
+    input redirectE, redirectD;         // Misprediction found in EX / JAL in decode
+    input [31:0] redirectPCE, redirectPCD;
+    input updateBtbE, branchTakenE;     // Branch resolving in EX
+    input [31:0] branchPCE, branchTargetE;
+    input StallF, StallD, FlushD;
     output [31:0] InstrD;
-    output [31:0] PCD, PCPlus4D;
+    output [31:0] PCD, PCPlus4D, PredPCD;
+    output ValidD;
+    output IMiss, IFill;              // Fetch waits for a line / a fill starts
 
     // Declaring interim wires
-    wire [31:0] pco, pci, nextPC;
+    wire [31:0] pco, pci, nextPC, predPC, seqPC, decPC;
     wire [31:0] inst;
+    wire btbTaken, predTaken;
+    wire [31:0] btbTarget;
 
     // Declaration of Register
     reg [31:0] inst_reg;
-    reg [31:0] pco_reg, nextPC_reg;
+    reg [31:0] pco_reg, nextPC_reg, predPC_reg;
+    reg valid_reg;
 
     // Initiation of Modules
-    // PC Mux
-    Mux2to1 #(.size(32)) m_Mux_PC(
-        .sel(branchMuxSel),
+    // Branch Target Buffer
+    btb m_BTB(
+        .clk(clk),
+        .rst(rst),
+        .pc(pco),
+        .taken(btbTaken),
+        .target(btbTarget),
+        .updateE(updateBtbE),
+        .pcE(branchPCE),
+        .takenE(branchTakenE),
+        .targetE(branchTargetE),
+        .updateD(redirectD),
+        .pcD(PCD),
+        .targetD(redirectPCD)
+    );
+
+`ifdef NO_BTB
+    assign predTaken = 1'b0;    // Static not-taken, to compare against
+`else
+    assign predTaken = btbTaken;
+`endif
+
+    // Prediction Mux
+    Mux2to1 #(.size(32)) m_Mux_Pred(
+        .sel(predTaken),
         .s0(nextPC),
-        .s1(branchTarget),
+        .s1(btbTarget),
+        .out(predPC)
+    );
+
+    // Stall Mux: hold the PC while decode is stalled
+    Mux2to1 #(.size(32)) m_Mux_Stall(
+        .sel(StallF),
+        .s0(predPC),
+        .s1(pco),
+        .out(seqPC)
+    );
+
+    // Redirect Muxes: EX is older than decode and wins
+    Mux2to1 #(.size(32)) m_Mux_RedirectD(
+        .sel(redirectD),
+        .s0(seqPC),
+        .s1(redirectPCD),
+        .out(decPC)
+    );
+
+    Mux2to1 #(.size(32)) m_Mux_PC(
+        .sel(redirectE),
+        .s0(decPC),
+        .s1(redirectPCE),
         .out(pci)
     );
 
@@ -37,12 +103,47 @@ module fetch_cycle(clk, rst, branchMuxSel, branchTarget, InstrD, PCD, PCPlus4D);
         .pc_o(pco)
     );
 
+`ifdef CACHES
+    // Instruction Cache over its own backing memory
+    wire imem_req, imem_ready;
+    wire [31:0] imem_addr;
+    wire [LINE_WORDS*32-1:0] imem_rline;
+
+    icache #(.WAYS(ICACHE_WAYS), .SETS(ICACHE_SETS), .LINE_WORDS(LINE_WORDS)) m_ICache(
+        .clk(clk),
+        .rst(rst),
+        .addr(pco),
+        .inst(inst),
+        .miss(IMiss),
+        .fill(IFill),
+        .mem_req(imem_req),
+        .mem_addr(imem_addr),
+        .mem_ready(imem_ready),
+        .mem_rline(imem_rline)
+    );
+
+    backing_mem #(.BYTES(MEM_BYTES), .LINE_WORDS(LINE_WORDS), .LATENCY(MEM_LATENCY),
+                  .BIG_ENDIAN(1), .INIT_FILE("instructionset.dat")) m_InstMem(
+        .clk(clk),
+        .rst(rst),
+        .req(imem_req),
+        .we(1'b0),
+        .addr(imem_addr),
+        .wline({LINE_WORDS{32'h00000000}}),
+        .ready(imem_ready),
+        .rline(imem_rline)
+    );
+`else
     // Instruction Memory
     InstructionMemory m_InstMem(
         .readAddr(pco),
         .inst(inst)
     );
 
+    assign IMiss = 1'b0;
+    assign IFill = 1'b0;
+`endif
+
     // PC Adder
     Adder m_Adder_1(
         .a(pco),
@@ -56,10 +157,20 @@ module fetch_cycle(clk, rst, branchMuxSel, branchTarget, InstrD, PCD, PCPlus4D);
             inst_reg  <= 32'h00000000;
             pco_reg   <= 32'h00000000;
             nextPC_reg <= 32'h00000000;
-        end else begin
+            predPC_reg <= 32'h00000000;
+            valid_reg <= 1'b0;
+        end else if (FlushD) begin
+            inst_reg  <= 32'h00000000;
+            pco_reg   <= 32'h00000000;
+            nextPC_reg <= 32'h00000000;
+            predPC_reg <= 32'h00000000;
+            valid_reg <= 1'b0;
+        end else if (!StallD) begin
             inst_reg  <= inst;
             pco_reg   <= pco;
             nextPC_reg <= nextPC;
+            predPC_reg <= predPC;   // Checked in decode (JAL) or EX (branches)
+            valid_reg <= (inst != 32'h00000000);  // Zero words past the program are bubbles
         end
     end
 
@@ -67,5 +178,7 @@ module fetch_cycle(clk, rst, branchMuxSel, branchTarget, InstrD, PCD, PCPlus4D);
     assign InstrD = (rst == 1'b0) ? 32'h00000000 : inst_reg;
     assign PCD = (rst == 1'b0) ? 32'h00000000 : pco_reg;
     assign PCPlus4D = (rst == 1'b0) ? 32'h00000000 : nextPC_reg;
+    assign PredPCD = (rst == 1'b0) ? 32'h00000000 : predPC_reg;
+    assign ValidD = (rst == 1'b0) ? 1'b0 : valid_reg;
 
 endmodule
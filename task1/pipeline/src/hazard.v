@@ -1,9 +1,16 @@
-module hazard_unit(rst, RegWriteM, RegWriteW, RD_M, RD_W, Rs1_E, Rs2_E, ForwardAE, ForwardBE);
+module hazard_unit(rst, RegWriteM, RegWriteW, RD_M, RD_W, Rs1_E, Rs2_E, ForwardAE, ForwardBE,
+    Op_D, Rs1_D, Rs2_D, RD_E, MemReadE, MispredictE, MispredictD, ForwardAD, ForwardBD, StallF, StallD, FlushD, FlushE, RedirectD,
+    IMiss, DMiss, StallE, StallM, StallW, RedirectE, LoadUseStall);
 
     // Declaration of I/Os
-    input rst, RegWriteM, RegWriteW;
-    input [4:0] RD_M, RD_W, Rs1_E, Rs2_E;
+    input rst, RegWriteM, RegWriteW, MemReadE, MispredictE, MispredictD, IMiss, DMiss;
+    input [4:0] RD_M, RD_W, Rs1_E, Rs2_E, Rs1_D, Rs2_D, RD_E;
+    input [6:0] Op_D;
     output [1:0] ForwardAE, ForwardBE;
+    output ForwardAD, ForwardBD, StallF, StallD, FlushD, FlushE, RedirectD;
+    output StallE, StallM, StallW, RedirectE, LoadUseStall;
+
+    wire UsesRs1_D, UsesRs2_D, lwStall;
     
     assign ForwardAE = (rst == 1'b0) ? 2'b00 : 
                        ((RegWriteM == 1'b1) & (RD_M != 5'h00) & (RD_M == Rs1_E)) ? 2'b10 :
@@ -13,4 +20,39 @@ module hazard_unit(rst, RegWriteM, RegWriteW, RD_M, RD_W, Rs1_E, Rs2_E, ForwardA
                        ((RegWriteM == 1'b1) & (RD_M != 5'h00) & (RD_M == Rs2_E)) ? 2'b10 :
                        ((RegWriteW == 1'b1) & (RD_W != 5'h00) & (RD_W == Rs2_E)) ? 2'b01 : 2'b00;
 
-endmodule
\ No newline at end of file
+    // Register.v writes on the same edge that latches the decode read,
+    // so a writeback to a register being read in decode is bypassed
+    assign ForwardAD = rst & RegWriteW & (RD_W != 5'h00) & (RD_W == Rs1_D);
+    assign ForwardBD = rst & RegWriteW & (RD_W != 5'h00) & (RD_W == Rs2_D);
+
+    // Only R-type, stores and branches read rs2, and JAL reads nothing;
+    // elsewhere those bits are immediate and must not cause a stall
+    assign UsesRs1_D = (Op_D != 7'b1101111);
+    assign UsesRs2_D = (Op_D == 7'b0110011) | (Op_D == 7'b0100011) | (Op_D == 7'b1100011);
+
+    // Load-use: a load in EX has nothing to forward until it reaches W, so
+    // hold F and D for a cycle and send a bubble into EX
+    assign lwStall = rst & MemReadE & (RD_E != 5'h00) &
+                     ((UsesRs1_D & (RD_E == Rs1_D)) | (UsesRs2_D & (RD_E == Rs2_D)));
+
+    // A D-cache miss freezes every stage, W included so that its result
+    // stays there to forward; nothing else may act while it lasts. An
+    // I-cache miss holds the PC and feeds bubbles into decode.
+    assign StallF = lwStall | IMiss | DMiss;
+    assign StallD = lwStall | DMiss;
+    assign StallE = DMiss;
+    assign StallM = DMiss;
+    assign StallW = DMiss;
+    assign LoadUseStall = lwStall & ~DMiss;
+
+    // A mispredicted branch is found in EX: squash the two instructions
+    // fetched behind it, in F (into D) and in D (into E). A JAL that fetch
+    // did not predict is caught in decode and only squashes F. Decode's
+    // redirect waits while it is stalled and is moot under an EX one.
+    assign RedirectE = MispredictE & ~DMiss;
+    assign RedirectD = MispredictD & ~lwStall & ~MispredictE & ~DMiss;
+
+    assign FlushD = RedirectE | RedirectD | (IMiss & ~lwStall & ~DMiss);
+    assign FlushE = (lwStall | MispredictE) & ~DMiss;
+
+endmodule
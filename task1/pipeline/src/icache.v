@@ -0,0 +1,88 @@
+// Instruction cache: WAYS (1 or 2) x SETS lines of LINE_WORDS words,
+// read-only, filled a line at a time from backing_mem. miss is high while
+// addr is not present; the pipeline stalls fetch until the fill lands.
+// The two-way version replaces the least recently used way.
+module icache #(
+    parameter WAYS = 1,
+    parameter SETS = 16,
+    parameter LINE_WORDS = 4
+)
+(
+    input clk,
+    input rst,
+    input [31:0] addr,
+    output [31:0] inst,
+    output miss,
+    output fill,                // A line fill starts: one per miss
+    // Backing memory
+    output reg mem_req,
+    output [31:0] mem_addr,
+    input mem_ready,
+    input [LINE_WORDS*32-1:0] mem_rline
+);
+
+    localparam OFF = $clog2(LINE_WORDS * 4);
+    localparam IDX = $clog2(SETS);
+    localparam TAG = 32 - OFF - IDX;
+    localparam WORD = LINE_WORDS > 1 ? OFF - 2 : 1;    // Word-in-line bits
+
+    // Way w of set s is entry w*SETS + s
+    reg valid [0:WAYS*SETS-1];
+    reg [TAG-1:0] tags [0:WAYS*SETS-1];
+    reg [LINE_WORDS*32-1:0] lines [0:WAYS*SETS-1];
+    reg lru [0:SETS-1];         // Way to replace next
+
+    reg [31:0] fill_addr;
+
+    wire [IDX-1:0] set = addr[OFF+IDX-1:OFF];
+    wire [TAG-1:0] tag = addr[31:OFF+IDX];
+    wire [WORD-1:0] word;
+    wire hit0 = valid[set] && (tags[set] == tag);
+    wire hit1 = (WAYS == 2) && valid[SETS + set] && (tags[SETS + set] == tag);
+    wire [LINE_WORDS*32-1:0] line = hit1 ? lines[SETS + set] : lines[set];
+
+    // A one-word line has no word field to select
+    generate
+        if (LINE_WORDS > 1) begin : g_word
+            assign word = addr[OFF-1:2];
+        end
+        else begin : g_word
+            assign word = 1'b0;
+        end
+    endgenerate
+
+    wire [IDX-1:0] fill_set = fill_addr[OFF+IDX-1:OFF];
+    wire fill_way = (WAYS == 2) && (valid[fill_set] ? (valid[SETS + fill_set] ? lru[fill_set] : 1'b1) : 1'b0);
+
+    assign inst = line[word*32 +: 32];
+    assign miss = !(hit0 || hit1);
+    assign fill = miss && !mem_req;
+    assign mem_addr = fill_addr;
+
+    integer i;
+    always @(posedge clk) begin
+        if (~rst) begin
+            for (i = 0; i < WAYS*SETS; i = i + 1)
+                valid[i] <= 1'b0;
+            for (i = 0; i < SETS; i = i + 1)
+                lru[i] <= 1'b0;
+            mem_req <= 1'b0;
+        end
+        else if (mem_req) begin
+            if (mem_ready) begin
+                valid[fill_way*SETS + fill_set] <= 1'b1;
+                tags[fill_way*SETS + fill_set] <= fill_addr[31:OFF+IDX];
+                lines[fill_way*SETS + fill_set] <= mem_rline;
+                lru[fill_set] <= !fill_way;
+                mem_req <= 1'b0;
+            end
+        end
+        else if (miss) begin
+            fill_addr <= {addr[31:OFF], {OFF{1'b0}}};
+            mem_req <= 1'b1;
+        end
+        else if (WAYS == 2)
+            lru[set] <= hit0;   // The other way is now the older one
+    end
+
+endmodule
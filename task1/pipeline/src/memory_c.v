@@ -1,13 +1,26 @@
+`ifdef CACHES
+`include "dcache.v"
+// `include "backing_mem.v"
+`else
 `include "DataMemory.v"
+`endif
 module memory_cycle(clk, rst, RegWriteM, MemWriteM, ResultSrcM,MemReadM, RD_M, PCPlus4M, WriteDataM, 
-    ALU_ResultM, RegWriteW, ResultSrcW, RD_W, PCPlus4W, ALU_ResultW, ReadDataW);
+    ALU_ResultM, RegWriteW, ResultSrcW, RD_W, PCPlus4W, ALU_ResultW, ReadDataW, ValidM, ValidW, StallW, DMiss, DFill);
+
+    // Cache geometry and backing memory, for CACHES builds (see dcache.v)
+    parameter DCACHE_WAYS = 2;
+    parameter DCACHE_SETS = 8;
+    parameter LINE_WORDS = 4;
+    parameter MEM_BYTES = 16384;
+    parameter MEM_LATENCY = 10;
     
     // Declaration of I/Os
-    input clk, rst, RegWriteM, MemWriteM, ResultSrcM,MemReadM;
+    input clk, rst, RegWriteM, MemWriteM, ResultSrcM,MemReadM, ValidM, StallW;
     input [4:0] RD_M; 
     input [31:0] PCPlus4M, WriteDataM, ALU_ResultM;
 
-    output RegWriteW, ResultSrcW; 
+    output RegWriteW, ResultSrcW, ValidW; 
+    output DMiss, DFill;                // The access in MEM waits / a miss starts
     output [4:0] RD_W;
     output [31:0] PCPlus4W, ALU_ResultW, ReadDataW;
 
@@ -15,11 +28,48 @@ module memory_cycle(clk, rst, RegWriteM, MemWriteM, ResultSrcM,MemReadM, RD_M, P
     wire [31:0] ReadDataM;
 
     // Declaration of Interim Registers
-    reg RegWriteM_r, ResultSrcM_r;
+    reg RegWriteM_r, ResultSrcM_r, ValidM_r;
     reg [4:0] RD_M_r;
     reg [31:0] PCPlus4M_r, ALU_ResultM_r, ReadDataM_r;
 
     // Declaration of Module Initiation
+`ifdef CACHES
+    wire dmem_req, dmem_we, dmem_ready;
+    wire [31:0] dmem_addr;
+    wire [LINE_WORDS*32-1:0] dmem_wline, dmem_rline;
+
+    dcache #(.WAYS(DCACHE_WAYS), .SETS(DCACHE_SETS), .LINE_WORDS(LINE_WORDS)) m_DCache (
+                        .clk(clk),
+                        .rst(rst),
+                        .re(MemReadM),
+                        .we(MemWriteM),
+                        .addr(ALU_ResultM),
+                        .wdata(WriteDataM),
+                        .rdata(ReadDataM),
+                        .miss(DMiss),
+                        .fill(DFill),
+                        .mem_req(dmem_req),
+                        .mem_we(dmem_we),
+                        .mem_addr(dmem_addr),
+                        .mem_wline(dmem_wline),
+                        .mem_ready(dmem_ready),
+                        .mem_rline(dmem_rline)
+                    );
+
+    backing_mem #(.BYTES(MEM_BYTES), .LINE_WORDS(LINE_WORDS), .LATENCY(MEM_LATENCY)) dmem (
+                        .clk(clk),
+                        .rst(rst),
+                        .req(dmem_req),
+                        .we(dmem_we),
+                        .addr(dmem_addr),
+                        .wline(dmem_wline),
+                        .ready(dmem_ready),
+                        .rline(dmem_rline)
+                    );
+`else
+    assign DMiss = 1'b0;
+    assign DFill = 1'b0;
+
     DataMemory dmem (
                         .clk(clk),
                         .rst(rst),
@@ -29,6 +79,7 @@ module memory_cycle(clk, rst, RegWriteM, MemWriteM, ResultSrcM,MemReadM, RD_M, P
                         .address(ALU_ResultM),
                         .readData(ReadDataM)
                     );
+`endif
 
 
     // Memory Stage Register Logic
@@ -36,14 +87,16 @@ module memory_cycle(clk, rst, RegWriteM, MemWriteM, ResultSrcM,MemReadM, RD_M, P
         if (rst == 1'b0) begin
             RegWriteM_r <= 1'b0; 
             ResultSrcM_r <= 1'b0;
+            ValidM_r <= 1'b0;
             RD_M_r <= 5'h00;
             PCPlus4M_r <= 32'h00000000; 
             ALU_ResultM_r <= 32'h00000000; 
             ReadDataM_r <= 32'h00000000;
         end
-        else begin
+        else if (!StallW) begin
             RegWriteM_r <= RegWriteM; 
             ResultSrcM_r <= ResultSrcM;
+            ValidM_r <= ValidM;
             RD_M_r <= RD_M;
             PCPlus4M_r <= PCPlus4M; 
             ALU_ResultM_r <= ALU_ResultM; 
@@ -54,6 +107,7 @@ module memory_cycle(clk, rst, RegWriteM, MemWriteM, ResultSrcM,MemReadM, RD_M, P
     // Declaration of output assignments
     assign RegWriteW = RegWriteM_r;
     assign ResultSrcW = ResultSrcM_r;
+    assign ValidW = ValidM_r;
     assign RD_W = RD_M_r;
     assign PCPlus4W = PCPlus4M_r;
     assign ALU_ResultW = ALU_ResultM_r;
@@ -6,46 +6,96 @@
 `include "memory_c.v"
 `include "writeback.v"
 `include "hazard.v"  // ✅ Hazard Unit
+`include "counters.v"
+`ifdef CACHES
+`include "backing_mem.v"
+`endif
 
-module pipelined_riscv(
+module pipelined_riscv #(
+    // Caches and backing memories, used when built with CACHES defined
+    parameter ICACHE_WAYS = 1,
+    parameter ICACHE_SETS = 16,
+    parameter DCACHE_WAYS = 2,
+    parameter DCACHE_SETS = 8,
+    parameter LINE_WORDS = 4,
+    parameter MEM_BYTES = 16384,
+    parameter MEM_LATENCY = 10
+)
+(
     input clk,
     input rst
 );
 
     // Fetch Cycle Wires
-    wire [31:0] InstrD, PCD, PCPlus4D;
+    wire [31:0] InstrD, PCD, PCPlus4D, PredPCD, RedirectPCD;
+    wire ValidD, MispredictD, IMiss, IFill;
 
     // Decode Cycle Wires
-    wire RegWriteE, ALUSrcE, MemWriteE, MemReadE, ResultSrcE, BranchE;
+    wire RegWriteE, ALUSrcE, MemWriteE, MemReadE, ResultSrcE, BranchE, JumpE, CsrE, ValidE;
     wire [3:0] ALUControlE;
     wire [31:0] RD1_E, RD2_E, Imm_Ext_E;
     wire [4:0] RS1_E, RS2_E, RD_E;
-    wire [31:0] PCE, PCPlus4E;
+    wire [31:0] PCE, PCPlus4E, PredPCE;
 
     // Execute Cycle Wires
-    wire PCSrcE, RegWriteM, MemWriteM, MemReadM, ResultSrcM;
+    wire PCSrcE, MispredictE, RegWriteM, MemWriteM, MemReadM, ResultSrcM, ValidM;
     wire [4:0] RD_M;
     wire [31:0] PCPlus4M, WriteDataM, ALU_ResultM;
-    wire [31:0] PCTargetE;
+    wire [31:0] PCTargetE, RedirectPCE;
     wire [1:0] ForwardAE, ForwardBE;  // ✅ Only Data Forwarding (Updated naming)
+    wire [31:0] CsrDataE;
 
     // Memory Cycle Wires
-    wire RegWriteW, ResultSrcW;
+    wire RegWriteW, ResultSrcW, ValidW, DMiss, DFill;
     wire [4:0] RD_W;
     wire [31:0] PCPlus4W, ALU_ResultW, ReadDataW;
 
     // Writeback Cycle Wire
     wire [31:0] ResultW;
 
+    // Hazard Unit Wires
+    wire ForwardAD, ForwardBD, StallF, StallD, FlushD, FlushE, RedirectD;
+    wire StallE, StallM, StallW, RedirectE, LoadUseStall;
+
+    // Nothing may train or count twice while a cache miss holds a stage
+    wire TrainBtbE = BranchE & ~StallE;
+    wire RetireW = ValidW & ~StallW;
+`ifdef CACHES
+    wire IAccess = ~StallF;
+    wire DAccess = (MemReadM | MemWriteM) & ~StallM;
+`else
+    wire IAccess = 1'b0;        // No caches, nothing to count
+    wire DAccess = 1'b0;
+`endif
+
     // FETCH STAGE
-    fetch_cycle fetch_stage(
+    fetch_cycle #(
+        .ICACHE_WAYS(ICACHE_WAYS),
+        .ICACHE_SETS(ICACHE_SETS),
+        .LINE_WORDS(LINE_WORDS),
+        .MEM_BYTES(MEM_BYTES),
+        .MEM_LATENCY(MEM_LATENCY)
+    ) fetch_stage(
         .clk(clk),
         .rst(rst),
-        .branchMuxSel(PCSrcE),      // PCSrcE decides branch or next instruction
-        .branchTarget(PCTargetE),   // Target address if branch is taken
+        .redirectE(RedirectE),      // Branch went the other way than predicted
+        .redirectPCE(RedirectPCE),
+        .redirectD(RedirectD),      // JAL fetch did not predict
+        .redirectPCD(RedirectPCD),
+        .updateBtbE(TrainBtbE),     // Train the BTB on every resolved branch
+        .branchPCE(PCE),
+        .branchTakenE(PCSrcE),
+        .branchTargetE(PCTargetE),
+        .StallF(StallF),
+        .StallD(StallD),
+        .FlushD(FlushD),
         .InstrD(InstrD),
         .PCD(PCD),
-        .PCPlus4D(PCPlus4D)
+        .PCPlus4D(PCPlus4D),
+        .PredPCD(PredPCD),
+        .ValidD(ValidD),
+        .IMiss(IMiss),
+        .IFill(IFill)
     );
 
     // DECODE STAGE
@@ -53,17 +103,28 @@ module pipelined_riscv(
         .clk(clk),
         .rst(rst),
         .RegWriteW(RegWriteW),
+        .StallE(StallE),
+        .FlushE(FlushE),
+        .ForwardAD(ForwardAD),
+        .ForwardBD(ForwardBD),
+        .ValidD(ValidD),
         .RDW(RD_W),
         .InstrD(InstrD),
         .PCD(PCD),
         .PCPlus4D(PCPlus4D),
+        .PredPCD(PredPCD),
         .ResultW(ResultW),
+        .MispredictD(MispredictD),
+        .RedirectPCD(RedirectPCD),
         .RegWriteE(RegWriteE),
         .ALUSrcE(ALUSrcE),
         .MemWriteE(MemWriteE),
         .MemReadE(MemReadE),
         .ResultSrcE(ResultSrcE),
         .BranchE(BranchE),
+        .JumpE(JumpE),
+        .CsrE(CsrE),
+        .ValidE(ValidE),
         .ALUControlE(ALUControlE),
         .RD1_E(RD1_E),
         .RD2_E(RD2_E),
@@ -71,6 +132,7 @@ module pipelined_riscv(
         .RD_E(RD_E),
         .PCE(PCE),
         .PCPlus4E(PCPlus4E),
+        .PredPCE(PredPCE),
         .RS1_E(RS1_E),
         .RS2_E(RS2_E)
     );
@@ -104,11 +166,26 @@ module pipelined_riscv(
         .ALU_ResultM(ALU_ResultM),
         .ResultW(ResultW),
         .ForwardA_E(ForwardAE),  // ✅ Data Forwarding
-        .ForwardB_E(ForwardBE)   // ✅ Data Forwarding
+        .ForwardB_E(ForwardBE),  // ✅ Data Forwarding
+        .CsrE(CsrE),
+        .CsrDataE(CsrDataE),
+        .ValidE(ValidE),
+        .ValidM(ValidM),
+        .JumpE(JumpE),
+        .PredPCE(PredPCE),
+        .MispredictE(MispredictE),
+        .RedirectPCE(RedirectPCE),
+        .StallM(StallM)
     );
 
     // MEMORY STAGE
-    memory_cycle memory_stage(
+    memory_cycle #(
+        .DCACHE_WAYS(DCACHE_WAYS),
+        .DCACHE_SETS(DCACHE_SETS),
+        .LINE_WORDS(LINE_WORDS),
+        .MEM_BYTES(MEM_BYTES),
+        .MEM_LATENCY(MEM_LATENCY)
+    ) memory_stage(
         .clk(clk),
         .rst(rst),
         .RegWriteM(RegWriteM),
@@ -124,7 +201,12 @@ module pipelined_riscv(
         .RD_W(RD_W),
         .PCPlus4W(PCPlus4W),
         .ALU_ResultW(ALU_ResultW),
-        .ReadDataW(ReadDataW)
+        .ReadDataW(ReadDataW),
+        .ValidM(ValidM),
+        .ValidW(ValidW),
+        .StallW(StallW),
+        .DMiss(DMiss),
+        .DFill(DFill)
     );
 
     // WRITEBACK STAGE
@@ -138,7 +220,7 @@ module pipelined_riscv(
         .ResultW(ResultW)
     );
 
-    // ✅ HAZARD UNIT (Only Data Hazard Handling)
+    // HAZARD UNIT: forwarding, load-use and cache-miss stalls, misprediction flushes
     hazard_unit hazard_unit_inst (
         .rst(rst),
         .RegWriteM(RegWriteM),
@@ -148,7 +230,44 @@ module pipelined_riscv(
         .Rs1_E(RS1_E),
         .Rs2_E(RS2_E),
         .ForwardAE(ForwardAE),  // ✅ Updated naming
-        .ForwardBE(ForwardBE)   // ✅ Updated naming
+        .ForwardBE(ForwardBE),  // ✅ Updated naming
+        .Op_D(InstrD[6:0]),
+        .Rs1_D(InstrD[19:15]),
+        .Rs2_D(InstrD[24:20]),
+        .RD_E(RD_E),
+        .MemReadE(MemReadE),
+        .MispredictE(MispredictE),
+        .MispredictD(MispredictD),
+        .ForwardAD(ForwardAD),
+        .ForwardBD(ForwardBD),
+        .StallF(StallF),
+        .StallD(StallD),
+        .FlushD(FlushD),
+        .FlushE(FlushE),
+        .RedirectD(RedirectD),
+        .IMiss(IMiss),
+        .DMiss(DMiss),
+        .StallE(StallE),
+        .StallM(StallM),
+        .StallW(StallW),
+        .RedirectE(RedirectE),
+        .LoadUseStall(LoadUseStall)
+    );
+
+    // PERFORMANCE COUNTERS (csrr)
+    perf_counters counters (
+        .clk(clk),
+        .rst(rst),
+        .RetireW(RetireW),
+        .LoadStall(LoadUseStall),
+        .Mispredict(RedirectE),
+        .JumpRedirect(RedirectD),
+        .IAccess(IAccess),
+        .IFill(IFill),
+        .DAccess(DAccess),
+        .DFill(DFill),
+        .CsrAddr(Imm_Ext_E[11:0]),
+        .CsrData(CsrDataE)
     );
 
 endmodule
@@ -0,0 +1,31 @@
+#!/bin/sh
+# Simulated cycles per second for one program under Verilator and under the
+# iverilog flow of "How to Run Simulation", with and without its VCD dump.
+#
+#   ./bench.sh [program.dat]       CYCLES=N sets the length (default 200000)
+set -e
+cd "$(dirname "$0")"
+PROG=$(realpath "${1:-loop.dat}")
+CYCLES=${CYCLES:-200000}
+
+make -s TRACE= obj_dir/Vsim_top
+iverilog -I../src -o obj_dir/pipeline_tb.vvp ../src/pipelinetop.v ../simulations/pipeline_tb.v
+cp "$PROG" obj_dir/instructionset.dat
+cd obj_dir
+
+# time_run LABEL CMD...: wall time of CMD, reported as cycles per second
+time_run() {
+    label=$1
+    shift
+    t0=$(date +%s.%N)
+    "$@" > /dev/null
+    t1=$(date +%s.%N)
+    awk -v l="$label" -v c="$CYCLES" -v a="$t0" -v b="$t1" \
+        'BEGIN { printf "%-20s %10.3f s %14.0f cycles/s\n", l, b - a, c / (b - a) }'
+}
+
+echo "$(basename "$PROG"), $CYCLES cycles"
+time_run verilator ./Vsim_top --max-cycles "$CYCLES" "$PROG" || true
+time_run "iverilog" vvp -n pipeline_tb.vvp +cycles="$CYCLES" +novcd
+time_run "iverilog + vcd" vvp -n pipeline_tb.vvp +cycles="$CYCLES"
+rm -f dump.vcd
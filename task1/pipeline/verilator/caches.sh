@@ -0,0 +1,31 @@
+#!/bin/sh
+# CPI and D-cache hits/misses of the CACHES build for a few D-cache
+# geometries (ways x sets x 4-word lines), each in its own build directory.
+#
+#   ./caches.sh [program.dat ...]   default: memwalk.dat bitscan.dat
+set -e
+cd "$(dirname "$0")"
+[ $# -gt 0 ] || set -- memwalk.dat bitscan.dat
+
+CONFIGS="1x8 2x8 2x32 2x128"
+
+for c in $CONFIGS; do
+    make -s CACHES=1 OBJ=obj_dir_caches_$c \
+        CACHE_PARAMS="-GDCACHE_WAYS=${c%x*} -GDCACHE_SETS=${c#*x}"
+done
+
+# stats BUILD PROGRAM: "CPI hits misses" from the driver's summary
+stats() {
+    "$1"/Vsim_top "$2" | sed -n \
+        -e 's/.*CPI \([0-9.]*\).*/\1/p' \
+        -e 's/.*D\$ \([0-9]*\) hits, \([0-9]*\) misses.*/\1 \2/p' | tr '\n' ' '
+}
+
+printf "%-16s %-8s %8s %10s %10s\n" program D\$ CPI hits misses
+for prog in "$@"; do
+    cp "$prog" instructionset.dat
+    for c in $CONFIGS; do
+        set -- $(stats obj_dir_caches_$c "$prog")
+        printf "%-16s %-8s %8s %10s %10s\n" "$(basename "$prog")" "$c" "$1" "$2" "$3"
+    done
+done
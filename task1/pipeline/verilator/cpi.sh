@@ -0,0 +1,22 @@
+#!/bin/sh
+# CPI of the loop programs with the BTB and with static not-taken
+# prediction (BTB=0). JALs resolve in decode in both builds.
+#
+#   ./cpi.sh [program.dat ...]      default: loop.dat bitscan.dat
+set -e
+cd "$(dirname "$0")"
+[ $# -gt 0 ] || set -- loop.dat bitscan.dat
+
+make -s BTB=1
+make -s BTB=0
+
+# cpi BUILD PROGRAM: the driver's "CPI x" figure
+cpi() {
+    "$1"/Vsim_top "$2" | sed -n 's/.*CPI \([0-9.]*\).*/\1/p'
+}
+
+printf "%-16s %10s %10s\n" program "no BTB" BTB
+for prog in "$@"; do
+    cp "$prog" instructionset.dat
+    printf "%-16s %10s %10s\n" "$(basename "$prog")" "$(cpi obj_dir_nobtb "$prog")" "$(cpi obj_dir "$prog")"
+done
@@ -0,0 +1,240 @@
+// Verilator driver for the pipeline (sim_top.v): loads a .dat program
+// image, runs to a halt and reports cycles, retired instructions and CPI.
+//
+//   Vsim_top [options] program.dat
+//
+// program.dat is in the $readmemb byte format InstructionMemory.v uses,
+// at most 128 bytes, or the instruction backing memory's size in a CACHES
+// build (sim_top reports which). The program ends at its first all-zero
+// word; the run halts once fetch is at or past that point and no valid
+// instruction is left in decode..writeback. Fetch is only redirected from
+// decode or EX, so it cannot come back after that.
+//
+// Waveforms need a build with TRACE=vcd or TRACE=fst (see Makefile) and
+// are written only for cycles inside [--wave-from, --wave-to).
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Vsim_top.h"
+#include "verilated.h"
+#if VM_TRACE_FST
+#include "verilated_fst_c.h"
+typedef VerilatedFstC WaveFile;
+#elif VM_TRACE
+#include "verilated_vcd_c.h"
+typedef VerilatedVcdC WaveFile;
+#endif
+
+namespace {
+
+constexpr unsigned RESET_CYCLES = 2;
+
+// Whitespace-separated binary bytes with // comments, as $readmemb takes them
+bool load_dat(const char *path, std::vector<uint8_t> &bytes) {
+    std::ifstream in(path);
+    std::string tok;
+
+    if (!in)
+        return false;
+    while (in >> tok) {
+        if (tok.compare(0, 2, "//") == 0) {
+            std::getline(in, tok);
+            continue;
+        }
+        if (tok.find_first_not_of("01_") != std::string::npos) {
+            fprintf(stderr, "sim: %s: bad byte '%s'\n", path, tok.c_str());
+            return false;
+        }
+        uint32_t v = 0;
+        for (char c : tok)
+            if (c != '_')
+                v = (v << 1) | uint32_t(c - '0');
+        bytes.push_back(uint8_t(v));
+    }
+    return true;
+}
+
+// Byte offset of the first all-zero instruction word
+uint32_t program_end(const std::vector<uint8_t> &bytes) {
+    uint32_t a = 0;
+    for (; a + 4 <= bytes.size(); a += 4)
+        if (!(bytes[a] | bytes[a + 1] | bytes[a + 2] | bytes[a + 3]))
+            break;
+    return a;
+}
+
+void usage() {
+    fprintf(stderr,
+            "usage: Vsim_top [options] program.dat\n"
+            "  -n, --max-cycles N   stop after N cycles (default 100000000)\n"
+            "  -t, --trace FILE     write architectural effects for iss/tracediff.py\n"
+            "  -w, --wave FILE      dump a VCD/FST waveform (TRACE=vcd|fst builds)\n"
+            "      --wave-from N    first cycle dumped (default 0)\n"
+            "      --wave-to N      first cycle not dumped (default: all)\n");
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    const char *prog_path = nullptr, *trace_path = nullptr, *wave_path = nullptr;
+    uint64_t max_cycles = 100000000, wave_from = 0, wave_to = UINT64_MAX;
+
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool has_arg = i + 1 < argc;
+
+        if ((a == "-n" || a == "--max-cycles") && has_arg)
+            max_cycles = strtoull(argv[++i], nullptr, 0);
+        else if ((a == "-t" || a == "--trace") && has_arg)
+            trace_path = argv[++i];
+        else if ((a == "-w" || a == "--wave") && has_arg)
+            wave_path = argv[++i];
+        else if (a == "--wave-from" && has_arg)
+            wave_from = strtoull(argv[++i], nullptr, 0);
+        else if (a == "--wave-to" && has_arg)
+            wave_to = strtoull(argv[++i], nullptr, 0);
+        else if (a[0] == '+')
+            continue;                   // Verilator's own plusargs
+        else if (a[0] != '-' && !prog_path)
+            prog_path = argv[i];
+        else {
+            usage();
+            return 2;
+        }
+    }
+    if (!prog_path) {
+        usage();
+        return 2;
+    }
+
+    std::vector<uint8_t> image;
+    if (!load_dat(prog_path, image)) {
+        fprintf(stderr, "sim: cannot load %s\n", prog_path);
+        return 2;
+    }
+    auto ctx = std::make_unique<VerilatedContext>();
+    ctx->commandArgs(argc, argv);
+#if VM_TRACE
+    ctx->traceEverOn(true);
+#endif
+    auto top = std::make_unique<Vsim_top>(ctx.get());
+
+    top->eval();
+    const unsigned imem_bytes = top->imem_bytes;
+    if (image.size() > imem_bytes) {
+        fprintf(stderr, "sim: %s has %zu bytes, instruction memory holds %u\n",
+                prog_path, image.size(), imem_bytes);
+        return 2;
+    }
+    image.resize(imem_bytes, 0);
+    const uint32_t end = program_end(image);
+
+#if VM_TRACE
+    std::unique_ptr<WaveFile> wave;
+    if (wave_path) {
+        wave = std::make_unique<WaveFile>();
+        top->trace(wave.get(), 99);
+        wave->open(wave_path);
+    }
+#else
+    (void)wave_from;
+    (void)wave_to;
+    if (wave_path) {
+        fprintf(stderr, "sim: built without tracing; rebuild with TRACE=vcd or TRACE=fst\n");
+        return 2;
+    }
+#endif
+
+    FILE *trace = nullptr;
+    if (trace_path && !(trace = fopen(trace_path, "w"))) {
+        fprintf(stderr, "sim: cannot write %s\n", trace_path);
+        return 2;
+    }
+
+    uint64_t cycle = 0;
+    auto tick = [&]() {
+        top->clk = 1;
+        top->eval();
+#if VM_TRACE
+        if (wave && cycle >= wave_from && cycle < wave_to)
+            wave->dump(2 * cycle + 1);
+#endif
+        top->clk = 0;
+        top->eval();
+#if VM_TRACE
+        if (wave && cycle >= wave_from && cycle < wave_to)
+            wave->dump(2 * cycle + 2);
+#endif
+        cycle++;
+    };
+
+    // Reset, writing the image while it is held; the register file and
+    // data memory clear on these edges too
+    top->clk = 0;
+    top->rst = 0;
+    top->eval();
+    for (unsigned a = 0; a < imem_bytes; a++) {
+        top->prog_we = 1;
+        top->prog_addr = a;
+        top->prog_data = image[a];
+        tick();
+    }
+    top->prog_we = 0;
+    for (unsigned i = 0; i < RESET_CYCLES; i++)
+        tick();
+    top->rst = 1;
+    top->eval();
+
+    const uint64_t start = cycle;
+    uint64_t retired = 0, limit = start + max_cycles;
+    bool halted = false;
+    auto t0 = std::chrono::steady_clock::now();
+
+    // Sample each cycle's values before the edge that commits them
+    while (cycle < limit) {
+        if (top->valid_w)
+            retired++;
+        if (trace) {
+            if (top->reg_write_w && top->rd_w)
+                fprintf(trace, "%08x x%u %08x\n", top->pc_w, top->rd_w, top->result_w);
+            if (top->mem_write_m)
+                fprintf(trace, "%08x mem %08x %08x\n", top->pc_m, top->addr_m, top->write_data_m);
+        }
+        if (top->pc_f >= end && !top->in_flight) {
+            halted = true;
+            break;
+        }
+        tick();
+    }
+
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    uint64_t cycles = cycle - start;
+
+    printf("sim: %s after %llu cycles, %llu instructions retired, CPI %.3f\n",
+           halted ? "halted" : "cycle limit", (unsigned long long)cycles,
+           (unsigned long long)retired, retired ? double(cycles) / retired : 0.0);
+    printf("sim: %llu load-use stall cycles, %llu branch mispredictions, %llu JAL redirects\n",
+           (unsigned long long)top->load_stalls, (unsigned long long)top->mispredicts,
+           (unsigned long long)top->jump_redirects);
+    if (top->icache_hits + top->icache_misses + top->dcache_hits + top->dcache_misses)
+        printf("sim: I$ %llu hits, %llu misses; D$ %llu hits, %llu misses\n",
+               (unsigned long long)top->icache_hits, (unsigned long long)top->icache_misses,
+               (unsigned long long)top->dcache_hits, (unsigned long long)top->dcache_misses);
+    printf("sim: %.3f s, %.0f cycles/s\n", secs, secs > 0 ? cycles / secs : 0.0);
+
+    top->final();
+#if VM_TRACE
+    if (wave)
+        wave->close();
+#endif
+    if (trace)
+        fclose(trace);
+    return halted ? 0 : 1;
+}
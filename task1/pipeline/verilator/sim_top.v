@@ -0,0 +1,88 @@
+// Verilator top for the pipeline: pipelined_riscv plus the taps the C++
+// driver (sim_main.cpp) needs, read through hierarchical references so the
+// pipeline itself stays untouched. While rst is low the driver writes the
+// program image into instruction memory one byte per clock through prog_*:
+// InstructionMemory, or the I-side backing memory in CACHES builds. The
+// parameters pass through to the caches (-G on the verilator line).
+module sim_top #(
+    parameter ICACHE_WAYS = 1,
+    parameter ICACHE_SETS = 16,
+    parameter DCACHE_WAYS = 2,
+    parameter DCACHE_SETS = 8,
+    parameter LINE_WORDS = 4,
+    parameter MEM_BYTES = 16384,
+    parameter MEM_LATENCY = 10
+)
+(
+    input clk,
+    input rst,
+    input prog_we,
+    input [31:0] prog_addr,
+    input [7:0] prog_data,
+    output [31:0] imem_bytes,   // How much prog_* can load
+    output [31:0] pc_f,         // Being fetched
+    output [31:0] pc_m,         // In MEM
+    output [31:0] pc_w,         // Committing in writeback
+    output valid_w,             // pc_w commits this cycle, not a bubble or a stall
+    output in_flight,           // Some instruction is still in D..W
+    output reg_write_w,
+    output [4:0] rd_w,
+    output [31:0] result_w,
+    output mem_write_m,
+    output [31:0] addr_m,
+    output [31:0] write_data_m,
+    output [63:0] load_stalls,  // Performance counters (counters.v)
+    output [63:0] mispredicts,
+    output [63:0] jump_redirects,
+    output [63:0] icache_hits,
+    output [63:0] icache_misses,
+    output [63:0] dcache_hits,
+    output [63:0] dcache_misses
+);
+
+    pipelined_riscv #(
+        .ICACHE_WAYS(ICACHE_WAYS),
+        .ICACHE_SETS(ICACHE_SETS),
+        .DCACHE_WAYS(DCACHE_WAYS),
+        .DCACHE_SETS(DCACHE_SETS),
+        .LINE_WORDS(LINE_WORDS),
+        .MEM_BYTES(MEM_BYTES),
+        .MEM_LATENCY(MEM_LATENCY)
+    ) dut (.clk(clk), .rst(rst));
+
+`ifdef CACHES
+    assign imem_bytes = MEM_BYTES;
+
+    always @(posedge clk) begin
+        if (!rst && prog_we)
+            dut.fetch_stage.m_InstMem.mem[prog_addr] <= prog_data;
+    end
+`else
+    assign imem_bytes = 32'd128;
+
+    always @(posedge clk) begin
+        if (!rst && prog_we)
+            dut.fetch_stage.m_InstMem.insts[prog_addr[6:0]] <= prog_data;
+    end
+`endif
+
+    assign pc_f = dut.fetch_stage.pco;
+    assign pc_m = dut.PCPlus4M - 32'd4;
+    assign pc_w = dut.PCPlus4W - 32'd4;
+    assign valid_w = dut.RetireW;
+    assign in_flight = dut.ValidD | dut.ValidE | dut.ValidM | dut.ValidW;
+    assign reg_write_w = dut.RegWriteW & ~dut.StallW;
+    assign rd_w = dut.RD_W;
+    assign result_w = dut.ResultW;
+    assign mem_write_m = dut.MemWriteM & ~dut.StallM;
+    assign addr_m = dut.ALU_ResultM;
+    assign write_data_m = dut.WriteDataM;
+    assign load_stalls = dut.counters.load_stalls;
+    assign mispredicts = dut.counters.mispredicts;
+    assign jump_redirects = dut.counters.jump_redirects;
+    assign icache_hits = dut.counters.icache_hits;
+    assign icache_misses = dut.counters.icache_misses;
+    assign dcache_hits = dut.counters.dcache_hits;
+    assign dcache_misses = dut.counters.dcache_misses;
+
+endmodule
@@ -0,0 +1,18 @@
+#pragma once
+
+/*
+ * Kernel printf shared by every task3 kernel. Output is formatted into a
+ * per-CPU line buffer and handed to the UART driver one line at a time
+ * (or when the buffer fills), through uart_write(buf, len), which each
+ * kernel's driver provides.
+ *
+ * Conversions: %d %i %u %x %X %p %s %c %%, with the '-' and '0' flags, a
+ * field width and the 'l' (a no-op on 32-bit ARM) and 'll' (64-bit)
+ * length modifiers on d, i, u, x and X.
+ */
+
+void printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+void vprintf(const char *fmt, __builtin_va_list args);
+
+// Push out a partial line still held in this CPU's buffer
+void printf_flush(void);
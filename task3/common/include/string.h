@@ -0,0 +1,12 @@
+#pragma once
+
+/*
+ * Memory routines shared by the task3 kernels (common/src/string.S).
+ * Standard signatures, so the calls GCC emits for struct copies and
+ * initialisers resolve here as well. Bulk loops move 32 bytes per
+ * LDM/STM; none of the routines touch VFP/NEON state.
+ */
+
+void *memset(void *dst, int c, unsigned int n);
+void *memcpy(void *dst, const void *src, unsigned int n);
+void *memmove(void *dst, const void *src, unsigned int n);
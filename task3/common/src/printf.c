@@ -0,0 +1,283 @@
+#include "printf.h"
+
+#define PRINTF_NR_CPUS      4
+#define PRINTF_LINE_SIZE    128
+
+#define FLAG_LEFT           (1 << 0)
+#define FLAG_ZERO           (1 << 1)
+
+// Provided by each kernel's UART driver
+void uart_write(const char *buf, unsigned int len);
+
+// A partial line belongs to the CPU, not the caller: the next printf on
+// the same core continues it
+struct line_buf {
+    unsigned int len;
+    char buf[PRINTF_LINE_SIZE];
+};
+
+static struct line_buf line_bufs[PRINTF_NR_CPUS];
+
+static const char hex_lower[] = "0123456789abcdef";
+static const char hex_upper[] = "0123456789ABCDEF";
+
+// MPIDR is not readable from User mode (question2 prints from EL0), so
+// there everything shares buffer 0
+static inline unsigned int cpu_id(unsigned int cpsr) {
+    unsigned int mpidr;
+
+    if ((cpsr & 0x1F) == 0x10)
+        return 0;
+    asm volatile("mrc p15, 0, %0, c0, c0, 5" : "=r"(mpidr));
+    return mpidr & (PRINTF_NR_CPUS - 1);
+}
+
+// An IRQ handler that prints must not land in the middle of a line being
+// built on the same core (cpsid is ignored in User mode, which is fine there)
+static inline unsigned int mask_irqs(void) {
+    unsigned int cpsr;
+    asm volatile("mrs %0, cpsr\n"
+                 "cpsid i" : "=r"(cpsr) :: "memory");
+    return cpsr;
+}
+
+static inline void restore_irqs(unsigned int cpsr) {
+    asm volatile("msr cpsr_c, %0" :: "r"(cpsr) : "memory");
+}
+
+// n / 10 as a multiply: 0xCCCCCCCD / 2^35 is exact for every 32-bit n
+static inline unsigned int div10(unsigned int n) {
+    return (unsigned int)(((unsigned long long)n * 0xCCCCCCCDu) >> 35);
+}
+
+static void flush(struct line_buf *lb) {
+    if (lb->len) {
+        uart_write(lb->buf, lb->len);
+        lb->len = 0;
+    }
+}
+
+// '\n' goes out as "\r\n" and ends the line
+static void put(struct line_buf *lb, char c) {
+    if (c == '\n') {
+        if (lb->len > PRINTF_LINE_SIZE - 2)
+            flush(lb);
+        lb->buf[lb->len++] = '\r';
+        lb->buf[lb->len++] = '\n';
+        flush(lb);
+        return;
+    }
+    lb->buf[lb->len++] = c;
+    if (lb->len == PRINTF_LINE_SIZE)
+        flush(lb);
+}
+
+static void pad(struct line_buf *lb, char c, int n) {
+    while (n-- > 0)
+        put(lb, c);
+}
+
+// digits holds ndigits characters, least significant first
+static void put_number(struct line_buf *lb, const char *digits, int ndigits,
+                       const char *prefix, int width, int flags) {
+    int plen = 0;
+
+    while (prefix[plen])
+        plen++;
+    width -= ndigits + plen;
+
+    if (!(flags & (FLAG_LEFT | FLAG_ZERO)))
+        pad(lb, ' ', width);
+    while (*prefix)
+        put(lb, *prefix++);
+    if ((flags & FLAG_ZERO) && !(flags & FLAG_LEFT))
+        pad(lb, '0', width);
+    while (ndigits--)
+        put(lb, digits[ndigits]);
+    if (flags & FLAG_LEFT)
+        pad(lb, ' ', width);
+}
+
+static int utoa10(unsigned int n, char *out) {
+    int i = 0;
+
+    do {
+        unsigned int q = div10(n);
+        out[i++] = '0' + (n - q * 10);
+        n = q;
+    } while (n);
+    return i;
+}
+
+// Long division by 10 in 16-bit steps, each of which div10 handles, so
+// %llu needs no 64-bit divide from libgcc
+static int utoa10ll(unsigned long long n, char *out) {
+    unsigned int hi = n >> 32, lo = (unsigned int)n;
+    int i = 0;
+
+    while (hi) {
+        unsigned int q = div10(hi), r = hi - q * 10, x, qmid;
+
+        hi = q;
+        x = (r << 16) | (lo >> 16);
+        qmid = div10(x);
+        r = x - qmid * 10;
+        x = (r << 16) | (lo & 0xFFFF);
+        q = div10(x);
+        lo = (qmid << 16) | q;
+        out[i++] = '0' + (x - q * 10);
+    }
+    return i + utoa10(lo, out + i);
+}
+
+static int utoa16(unsigned int n, char *out, const char *digits) {
+    int i = 0;
+
+    do {
+        out[i++] = digits[n & 0xF];
+        n >>= 4;
+    } while (n);
+    return i;
+}
+
+static int utoa16ll(unsigned long long n, char *out, const char *digits) {
+    int i = 0;
+
+    do {
+        out[i++] = digits[n & 0xF];
+        n >>= 4;
+    } while (n);
+    return i;
+}
+
+static void put_string(struct line_buf *lb, const char *s, int width, int flags) {
+    int len = 0;
+
+    if (!s)
+        s = "(null)";
+    if (!width) {
+        // Fast path: no padding, no length needed
+        while (*s)
+            put(lb, *s++);
+        return;
+    }
+
+    while (s[len])
+        len++;
+    if (!(flags & FLAG_LEFT))
+        pad(lb, ' ', width - len);
+    while (*s)
+        put(lb, *s++);
+    if (flags & FLAG_LEFT)
+        pad(lb, ' ', width - len);
+}
+
+void vprintf(const char *fmt, __builtin_va_list args) {
+    unsigned int cpsr = mask_irqs();
+    struct line_buf *lb = &line_bufs[cpu_id(cpsr)];
+    char digits[20];
+
+    for (const char *p = fmt; *p; p++) {
+        int flags = 0, width = 0, ll = 0, n;
+
+        if (*p != '%') {
+            put(lb, *p);
+            continue;
+        }
+
+        p++;
+        for (;; p++) {
+            if (*p == '-')
+                flags |= FLAG_LEFT;
+            else if (*p == '0')
+                flags |= FLAG_ZERO;
+            else
+                break;
+        }
+        while (*p >= '0' && *p <= '9')
+            width = width * 10 + (*p++ - '0');
+        if (*p == 'l' && *++p == 'l') {     // long is int here
+            ll = 1;
+            p++;
+        }
+
+        switch (*p) {
+        case 'd':
+        case 'i': {
+            if (ll) {
+                long long v = __builtin_va_arg(args, long long);
+
+                n = utoa10ll(v < 0 ? 0ull - (unsigned long long)v : (unsigned long long)v, digits);
+                put_number(lb, digits, n, v < 0 ? "-" : "", width, flags);
+                break;
+            }
+            int v = __builtin_va_arg(args, int);
+            // Negate as unsigned so INT_MIN survives
+            n = utoa10(v < 0 ? 0u - (unsigned int)v : (unsigned int)v, digits);
+            put_number(lb, digits, n, v < 0 ? "-" : "", width, flags);
+            break;
+        }
+        case 'u':
+            if (ll)
+                n = utoa10ll(__builtin_va_arg(args, unsigned long long), digits);
+            else
+                n = utoa10(__builtin_va_arg(args, unsigned int), digits);
+            put_number(lb, digits, n, "", width, flags);
+            break;
+        case 'x':
+            if (ll)
+                n = utoa16ll(__builtin_va_arg(args, unsigned long long), digits, hex_lower);
+            else
+                n = utoa16(__builtin_va_arg(args, unsigned int), digits, hex_lower);
+            put_number(lb, digits, n, "", width, flags);
+            break;
+        case 'X':
+            if (ll)
+                n = utoa16ll(__builtin_va_arg(args, unsigned long long), digits, hex_upper);
+            else
+                n = utoa16(__builtin_va_arg(args, unsigned int), digits, hex_upper);
+            put_number(lb, digits, n, "", width, flags);
+            break;
+        case 'p':
+            if (!width) {
+                width = 10;
+                flags |= FLAG_ZERO;
+            }
+            n = utoa16((unsigned int)__builtin_va_arg(args, void *), digits, hex_lower);
+            put_number(lb, digits, n, "0x", width, flags);
+            break;
+        case 's':
+            put_string(lb, __builtin_va_arg(args, const char *), width, flags);
+            break;
+        case 'c':
+            put(lb, (char)__builtin_va_arg(args, int));
+            break;
+        case '%':
+            put(lb, '%');
+            break;
+        case '\0':
+            p--;        // Lone '%' at the end of fmt
+            break;
+        default:
+            put(lb, '?');
+            break;
+        }
+    }
+
+    restore_irqs(cpsr);
+}
+
+void printf(const char *fmt, ...) {
+    __builtin_va_list args;
+
+    __builtin_va_start(args, fmt);
+    vprintf(fmt, args);
+    __builtin_va_end(args);
+}
+
+void printf_flush(void) {
+    unsigned int cpsr = mask_irqs();
+
+    flush(&line_bufs[cpu_id(cpsr)]);
+    restore_irqs(cpsr);
+}
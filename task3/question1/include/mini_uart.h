@@ -19,6 +19,7 @@ void uart_init();
 void uart_putc(unsigned char c);
 unsigned char uart_getc();
 void uart_puts(const char* str);
+void uart_write(const char* buf, unsigned int len);
 
 // New function prototypes
 int uart_gets(char* buffer, int max_len);
@@ -1,6 +0,0 @@
-#ifndef _PRINTF_H
-#define _PRINTF_H
-
-void uart_printf(const char* str);
-
-#endif
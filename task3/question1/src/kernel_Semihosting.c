@@ -3,7 +3,7 @@
 
 void kernel_main() {
     uart_init();
-    // give data in chunks of 4 please
+    // give data in chunks of 4 please; printf joins them back into lines
     char buff1[5] = "Hell";
     char buff2[5] = "o wo";
     char buff3[5] = "rld!";
@@ -14,14 +14,15 @@ void kernel_main() {
     char buff8[5] = "ukul";
 
 
-    uart_printf(buff1);
-    uart_printf(buff2);
-    uart_printf(buff3);
-    uart_printf(buff4);
-    uart_printf(buff5);
-    uart_printf(buff6);
-    uart_printf(buff7);
-    uart_printf(buff8);
+    printf("%s", buff1);
+    printf("%s", buff2);
+    printf("%s", buff3);
+    printf("%s", buff4);
+    printf("%s", buff5);
+    printf("%s", buff6);
+    printf("%s", buff7);
+    printf("%s", buff8);
+    printf_flush();     // Last line has no '\n'
 
     while (1) {
         char c = uart_getc();
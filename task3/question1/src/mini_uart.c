@@ -64,6 +64,12 @@ void uart_putc(unsigned char c) {
     *UART0_DR = c;
 }
 
+// Send a buffer as-is; printf hands over whole lines with "\r\n" already in
+void uart_write(const char* buf, unsigned int len) {
+    while (len--)
+        uart_putc(*buf++);
+}
+
 // Receive a character
 unsigned char uart_getc() {
     // Wait for UART to have received something
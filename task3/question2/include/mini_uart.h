@@ -5,5 +5,6 @@ void uart_init(void);
 void uart_send(char c);
 // char uart_recv(void);
 void uart_send_string(const char* str);
+void uart_write(const char* buf, unsigned int len);
 
 #endif  /* _UART_H */
\ No newline at end of file
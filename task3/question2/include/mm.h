@@ -12,7 +12,7 @@
 
 #ifndef __ASSEMBLER__
 
-void memzero(unsigned long src, unsigned long n);
+void memzero(unsigned long src, unsigned long n);     // common/src/string.S
 
 #endif
 
@@ -1 +0,0 @@
-void printf(char str[]) ;
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "mini_uart.h"
 #include "user.h"
 #include "utils.h"
+#include "printf.h"
 extern void* vectors;
 extern void* svc_handler;
 
@@ -9,17 +10,7 @@ void check_mode() {
     asm volatile("mrs %0, cpsr" : "=r"(mode));
     mode &= 0x1F;  // Mask to get mode bits only
 
-    // Print "MODE:"
-    uart_send('M');
-    uart_send('O');
-    uart_send('D');
-    uart_send('E');
-    uart_send(':');
-
-    // Convert decimal to ASCII (2 digits)
-    uart_send('0' + (mode / 10));   // tens place
-    uart_send('0' + (mode % 10));   // units place
-    uart_send('\n');
+    printf("MODE:%02u\n", mode);
 }
 
 void kernel_main(void) {
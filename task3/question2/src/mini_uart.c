@@ -54,6 +54,12 @@ void uart_send_string(const char* str) {
 }
 
 
+// printf sink: whole lines, "\r\n" already in place
+void uart_write(const char* buf, unsigned int len) {
+    while (len--)
+        uart_send(*buf++);
+}
+
 void uart_init(void)
 {
     unsigned int selector;
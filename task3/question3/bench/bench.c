@@ -0,0 +1,58 @@
+#include "bench.h"
+#include "printf.h"
+#include "timer.h"
+#include "utils.h"
+#include "arena.h"
+
+// Generic timer ticks to microseconds
+unsigned int bench_us(unsigned long long ticks) {
+    return (unsigned int)udiv64(ticks * 1000000, timer_freq());
+}
+
+// Events per second over a span of generic timer ticks
+unsigned int bench_per_sec(unsigned int count, unsigned long long ticks) {
+    if (!ticks)
+        return 0;
+    return (unsigned int)udiv64((unsigned long long)count * timer_freq(), (unsigned int)ticks);
+}
+
+// Throughput in units of 10^6 bytes per second
+unsigned int bench_mb_per_sec(unsigned int bytes, unsigned long long ticks) {
+    if (!ticks)
+        return 0;
+    return (unsigned int)udiv64(udiv64((unsigned long long)bytes * timer_freq(), (unsigned int)ticks), 1000000);
+}
+
+// Scratch buffers live only for the run, so they come from one arena that
+// is released at the end instead of sitting in .bss
+static struct arena bench_arena = ARENA_INIT;
+
+void *bench_alloc(unsigned int size, unsigned int align) {
+    void *p = arena_alloc(&bench_arena, size, align);
+
+    if (!p)
+        printf("bench: out of memory for %u bytes\n", size);
+    return p;
+}
+
+void bench_run_all(void) {
+    printf("bench: timer %u Hz\n", timer_freq());
+    bench_boot();
+    bench_uart();
+    bench_write();
+    bench_syscall();
+    bench_cache();
+    bench_mem();
+    bench_kmalloc();
+    bench_tlb();
+    bench_sched();
+    bench_asid();
+    bench_fault();
+    bench_exec();
+    bench_input();
+    bench_ipc();
+    bench_smp();
+    bench_idle();
+    printf("bench: done, %u bytes of scratch\n", bench_arena.bytes);
+    arena_release(&bench_arena);
+}
@@ -0,0 +1,72 @@
+#include "bench.h"
+#include "printf.h"
+#include "mm.h"
+#include "sched.h"
+#include "syscall.h"
+#include "user.h"
+#include "utils.h"
+#include "pmu.h"
+#include "timer.h"
+#include "asid.h"
+
+#define BENCH_ASID_MS       100
+#define BENCH_ASID_MAX      64
+
+static const int process_counts[] = { 2, 8, BENCH_ASID_MAX };
+
+// EL0 body: every process touches its own stack page and the shared user
+// image between yields, so each switch needs those translations again
+static void __user_text touch_loop(void) {
+    volatile unsigned int buf[64];
+
+    while (1) {
+        for (unsigned int i = 0; i < 64; i += 16)
+            buf[i]++;
+        sched_yield();
+    }
+}
+
+static void run(int asids, int n) {
+    struct sched_stats *st = &sched_stats[0];
+    int pids[BENCH_ASID_MAX];
+    unsigned long long t0, ticks;
+    unsigned int tlb0, tlb, flushes, sw;
+
+    asid_set_enabled(asids);
+    for (int i = 0; i < n; i++)
+        pids[i] = task_create(touch_loop);
+
+    memzero((unsigned long)sched_stats, sizeof(sched_stats));
+    flushes = asid_stats.flushes;
+    tlb0 = pmu_event_read(PMU_CNT_L1D_TLB_REFILL);
+    t0 = timer_count();
+    do {
+        schedule();
+        ticks = timer_count() - t0;
+    } while (ticks < timer_freq() / 1000 * BENCH_ASID_MS);
+    tlb = pmu_event_read(PMU_CNT_L1D_TLB_REFILL) - tlb0;
+    flushes = asid_stats.flushes - flushes;
+
+    for (int i = 0; i < n; i++)
+        task_kill(pids[i]);
+
+    sw = st->switches ? st->switches : 1;
+    printf("asid %s %u processes: %u switches/s, switch %u cycles, "
+           "%u.%u dTLB refills/switch, %u flushes\n", asids ? "on " : "off", n,
+           bench_per_sec(st->switches, ticks), st->switch_cycles / sw,
+           tlb / sw, tlb * 10 / sw % 10, flushes);
+}
+
+// Switching between processes, each with its own address space, with
+// non-global user mappings tagged by ASID against flushing the TLB on
+// every switch. Everything runs on core 0 so the PMU sees all of it.
+void bench_asid(void) {
+    sched_set_active(1);
+    for (unsigned int i = 0; i < sizeof(process_counts) / sizeof(process_counts[0]); i++) {
+        run(1, process_counts[i]);
+        run(0, process_counts[i]);
+    }
+    asid_set_enabled(1);
+    printf("asid: %u allocated, %u rollovers\n", asid_stats.allocs, asid_stats.rollovers);
+    sched_set_active(cpu_online_mask);
+}
@@ -0,0 +1,62 @@
+#include "bench.h"
+#include "printf.h"
+#include "cache.h"
+#include "mm.h"
+#include "syscall.h"
+#include "pmu.h"
+#include "timer.h"
+
+#define BENCH_BUF_SIZE      (64 * 1024)
+#define BENCH_CACHE_ROUNDS  16
+#define BENCH_SYSCALL_ITERS 100
+
+static unsigned int *src, *dst;        // From the bench arena
+
+// Plain word loop, the copy the kernel would otherwise write inline
+static void copy_words(unsigned int *d, const unsigned int *s, unsigned int bytes) {
+    for (unsigned int i = 0; i < bytes / 4; i++)
+        d[i] = s[i];
+}
+
+static void run(const char *state) {
+    unsigned int bytes = BENCH_BUF_SIZE * BENCH_CACHE_ROUNDS;
+    unsigned long long t0, zero_ticks, copy_ticks;
+    unsigned int best = 0xFFFFFFFF;
+
+    t0 = timer_count();
+    for (int r = 0; r < BENCH_CACHE_ROUNDS; r++)
+        memzero((unsigned long)dst, BENCH_BUF_SIZE);
+    zero_ticks = timer_count() - t0;
+
+    t0 = timer_count();
+    for (int r = 0; r < BENCH_CACHE_ROUNDS; r++)
+        copy_words(dst, src, BENCH_BUF_SIZE);
+    copy_ticks = timer_count() - t0;
+
+    for (int i = 0; i < BENCH_SYSCALL_ITERS; i++) {
+        unsigned int c0 = pmu_cycles();
+        syscall3(SYS_NULL, 0, 0, 0);
+        unsigned int c = pmu_cycles() - c0;
+        if (c < best)
+            best = c;
+    }
+
+    printf("%s: memzero %u MB/s, memcpy %u MB/s, null syscall %u cycles\n", state,
+           bench_mb_per_sec(bytes, zero_ticks), bench_mb_per_sec(bytes, copy_ticks), best);
+}
+
+// Same workloads with the L1/L2 caches and branch predictor off, then on
+void bench_cache(void) {
+    int was_enabled = cache_enabled();
+
+    src = bench_alloc(BENCH_BUF_SIZE, 32);
+    dst = bench_alloc(BENCH_BUF_SIZE, 32);
+
+    cache_disable();
+    run("caches off");
+    cache_enable();
+    run("caches on ");
+
+    if (!was_enabled)
+        cache_disable();
+}
@@ -0,0 +1,86 @@
+#include "bench.h"
+#include "printf.h"
+#include "mm.h"
+#include "sched.h"
+#include "string.h"
+#include "timer.h"
+#include "fault.h"
+#include "exec.h"
+
+#define BENCH_EXEC_RUNS     8
+#define BENCH_EXEC_IDLE     4       // Extra instances of the same program
+
+static int wait_state(int pid, int state) {
+    while (task_state(pid) != state)
+        schedule();
+    return task_exit_code(pid);
+}
+
+// Generic timer ticks from t0 to the first user instruction of the
+// program that pid ends up running: user/true.c exits with the low word
+// of the count it was entered at
+static unsigned int startup_ticks(int pid, unsigned int t0) {
+    unsigned int stamp = wait_state(pid, TASK_ZOMBIE);
+
+    task_kill(pid);
+    return stamp - t0;
+}
+
+static unsigned int per(unsigned int cycles, unsigned int n) {
+    return n ? cycles / n : 0;
+}
+
+// Process start-up from the initramfs: spawn to first instruction, the
+// same through execve() from a running program, and the frames each
+// further instance of a program costs while its text stays shared.
+// Everything runs on core 0.
+void bench_exec(void) {
+    struct fault_stats *st = &fault_stats[0];
+    const struct user_image *true_img = image_lookup("true");
+    const struct user_image *exec_img = image_lookup("exec_true");
+    const struct user_image *idle_img = image_lookup("idle");
+    unsigned long long spawn = 0, via_execve = 0;
+    int pids[BENCH_EXEC_IDLE];
+    unsigned int before, after;
+
+    if (!true_img || !exec_img || !idle_img) {
+        printf("exec: programs missing from the initramfs\n");
+        return;
+    }
+    sched_set_active(1);
+
+    memzero((unsigned long)fault_stats, sizeof(fault_stats));
+    for (unsigned int i = 0; i < BENCH_EXEC_RUNS; i++) {
+        unsigned int t0 = (unsigned int)timer_count();
+
+        spawn += startup_ticks(task_exec(true_img), t0);
+    }
+    printf("exec: spawn to first instruction %u us, %u file pages mapped, %u copied, %u cycles each\n",
+           bench_us(spawn / BENCH_EXEC_RUNS), st->file_maps / BENCH_EXEC_RUNS,
+           st->file_copies / BENCH_EXEC_RUNS,
+           per(st->file_cycles, st->file_maps + st->file_copies));
+
+    // The timer starts at the execve() call, recorded in exec_ticks
+    for (unsigned int i = 0; i < BENCH_EXEC_RUNS; i++) {
+        int pid = task_exec(exec_img);
+        unsigned int stamp = wait_state(pid, TASK_ZOMBIE);
+
+        via_execve += stamp - (unsigned int)task_exec_ticks(pid);
+        task_kill(pid);
+    }
+    printf("exec: execve to first instruction %u us\n", bench_us(via_execve / BENCH_EXEC_RUNS));
+
+    // The first instance may fill kmalloc magazines; count the ones after it
+    for (unsigned int i = 0; i < BENCH_EXEC_IDLE; i++) {
+        before = pages_free();
+        pids[i] = task_exec(idle_img);
+        wait_state(pids[i], TASK_SLEEPING);
+        after = pages_free();
+    }
+    printf("exec: %u frames per extra instance of idle, %u text pages shared\n",
+           before - after, idle_img->text_pages);
+    for (unsigned int i = 0; i < BENCH_EXEC_IDLE; i++)
+        task_kill(pids[i]);
+
+    sched_set_active(cpu_online_mask);
+}
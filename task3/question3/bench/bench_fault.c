@@ -0,0 +1,96 @@
+#include "bench.h"
+#include "printf.h"
+#include "mm.h"
+#include "sched.h"
+#include "syscall.h"
+#include "user.h"
+#include "string.h"
+#include "pmu.h"
+#include "fault.h"
+
+#define BENCH_FAULT_PAGES   64
+#define WORDS_PER_PAGE      (PAGE_SIZE / 4)
+
+// Set by the parent in fork_touch so the benchmark can reap the child
+static volatile int __user_data fork_child;
+
+// EL0 bodies, linked into the user image. Each write below is the first
+// to its heap page, so it takes one demand-zero fault.
+static void __user_text touch_heap(void) {
+    volatile unsigned int *heap = (volatile unsigned int *)USER_HEAP_BASE;
+
+    for (unsigned int i = 0; i < BENCH_FAULT_PAGES; i++)
+        heap[i * WORDS_PER_PAGE] = i;
+    exit(0);
+}
+
+// After the fork both sides write every page again: whichever gets there
+// first copies it, the other finds it no longer shared
+static void __user_text fork_touch(void) {
+    volatile unsigned int *heap = (volatile unsigned int *)USER_HEAP_BASE;
+    int pid;
+
+    for (unsigned int i = 0; i < BENCH_FAULT_PAGES; i++)
+        heap[i * WORDS_PER_PAGE] = i;
+    pid = fork();
+    if (pid > 0)
+        fork_child = pid;
+    for (unsigned int i = 0; i < BENCH_FAULT_PAGES; i++)
+        heap[i * WORDS_PER_PAGE] = i + 1;
+    exit(0);
+}
+
+static void reap(int pid) {
+    while (task_state(pid) != TASK_ZOMBIE)
+        schedule();
+    task_kill(pid);
+}
+
+static unsigned int per(unsigned int cycles, unsigned int n) {
+    return n ? cycles / n : 0;
+}
+
+// Cycles per page fault on the demand-zero and copy-on-write paths, and
+// fork of a process with BENCH_FAULT_PAGES private pages against what
+// copying them up front would cost. Everything runs on core 0.
+void bench_fault(void) {
+    struct fault_stats *st = &fault_stats[0];
+    unsigned int pages[BENCH_FAULT_PAGES];
+    unsigned int src, c0, copy_cycles;
+    int pid;
+
+    sched_set_active(1);
+
+    memzero((unsigned long)fault_stats, sizeof(fault_stats));
+    pid = task_create(touch_heap);
+    reap(pid);
+    printf("fault: %u demand-zero faults, %u cycles each\n",
+           st->zero_fills, per(st->zero_cycles, st->zero_fills));
+
+    memzero((unsigned long)fault_stats, sizeof(fault_stats));
+    fork_child = 0;
+    pid = task_create(fork_touch);
+    reap(pid);
+    while (!fork_child)
+        schedule();
+    reap(fork_child);
+    printf("fault: %u copy-on-write faults (%u copied, %u reused), %u cycles each\n",
+           st->cow_copies + st->cow_reuses, st->cow_copies, st->cow_reuses,
+           per(st->cow_cycles, st->cow_copies + st->cow_reuses));
+
+    // Baseline: an eager fork allocating and copying every page
+    src = alloc_page();
+    c0 = pmu_cycles();
+    for (unsigned int i = 0; i < BENCH_FAULT_PAGES; i++) {
+        pages[i] = alloc_page();
+        memcpy((void *)pages[i], (const void *)src, PAGE_SIZE);
+    }
+    copy_cycles = pmu_cycles() - c0;
+    for (unsigned int i = 0; i < BENCH_FAULT_PAGES; i++)
+        free_page(pages[i]);
+    free_page(src);
+    printf("fault: fork sharing %u pages %u cycles, copying them %u cycles\n",
+           st->fork_pages, per(st->fork_cycles, st->forks), copy_cycles);
+
+    sched_set_active(cpu_online_mask);
+}
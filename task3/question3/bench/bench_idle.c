@@ -0,0 +1,44 @@
+#include "bench.h"
+#include "printf.h"
+#include "mini_uart.h"
+#include "sched.h"
+#include "smp.h"
+#include "timer.h"
+#include "utils.h"
+
+#define BENCH_IDLE_US       1000000
+
+/*
+ * Idle residency (share of the time spent in WFI) and wakeups per second
+ * of each core while nothing runs; core 0's boot context sleeps through
+ * the window in WFI. With the periodic tick every core woke once per
+ * slice, whether or not it had work.
+ */
+void bench_idle(void) {
+    struct sched_stats before[NR_CPUS];
+    unsigned int irqs[NR_CPUS];
+    unsigned long long t0, ticks;
+
+    uart_flush();       // No TX interrupts inside the window
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++) {
+        before[cpu] = sched_stats[cpu];
+        irqs[cpu] = timer_irqs[cpu];
+    }
+    t0 = timer_count();
+    sleep_us(BENCH_IDLE_US);
+    ticks = timer_count() - t0;
+
+    printf("idle: periodic tick would be %u wakeups/s per core\n", 1000000 / SCHED_SLICE_US);
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++) {
+        struct sched_stats *st = &sched_stats[cpu];
+        unsigned long long idle = st->idle_ticks - before[cpu].idle_ticks;
+
+        if (!(cpu_online_mask & (1 << cpu)))
+            continue;
+        printf("idle: cpu%u residency %u.%u%%, %u wakeups/s, %u timer irqs/s\n", cpu,
+               (unsigned int)udiv64(idle * 100, (unsigned int)ticks),
+               (unsigned int)udiv64(idle * 1000, (unsigned int)ticks) % 10,
+               bench_per_sec(st->wakeups - before[cpu].wakeups, ticks),
+               bench_per_sec(timer_irqs[cpu] - irqs[cpu], ticks));
+    }
+}
@@ -0,0 +1,89 @@
+#include "bench.h"
+#include "printf.h"
+#include "mini_uart.h"
+#include "sched.h"
+#include "smp.h"
+#include "syscall.h"
+#include "timer.h"
+#include "user.h"
+#include "utils.h"
+
+#define BENCH_INPUT_ROUNDS      32
+#define BENCH_INPUT_TIMEOUT_US  100000  // Per byte, in case nothing loops back
+
+static char __user_data input_buf[64];
+
+// EL0 body: block in read() forever; the benchmark kills it
+static void __user_text input_reader(void) {
+    while (1)
+        read(STDIN_FILENO, input_buf, sizeof(input_buf));
+}
+
+static unsigned int ns(unsigned long long ticks) {
+    return (unsigned int)udiv64(ticks * 1000000000ULL, timer_freq());
+}
+
+/*
+ * Send c through the UART loopback once the reader is asleep in read(),
+ * and wait for it to run again. Adds the times from the RX interrupt that
+ * made the input readable, and from the send, to the reader resuming.
+ */
+static int round_trip(int pid, char c, unsigned long long *irq, unsigned long long *total,
+                      unsigned long long *worst) {
+    unsigned int wakeups = uart_stats.rx_wakeups;
+    unsigned long long sent, deadline, wake;
+
+    while (task_state(pid) != TASK_SLEEPING)
+        schedule();
+
+    sent = timer_count();
+    deadline = sent + timer_us_to_ticks(BENCH_INPUT_TIMEOUT_US);
+    uart_send_polled(c);
+    while (uart_stats.rx_wakeups == wakeups) {
+        if (timer_count() > deadline)
+            return 0;
+        schedule();
+    }
+
+    wake = uart_stats.rx_resume_ticks - uart_stats.rx_ready_ticks;
+    *irq += wake;
+    *total += uart_stats.rx_resume_ticks - sent;
+    if (wake > *worst)
+        *worst = wake;
+    return 1;
+}
+
+static void measure(const char *name, unsigned int mode, char c) {
+    unsigned long long irq = 0, total = 0, worst = 0;
+    unsigned int n = 0;
+    int pid;
+
+    uart_set_mode(mode);
+    pid = task_create(input_reader);
+    while (n < BENCH_INPUT_ROUNDS && round_trip(pid, c, &irq, &total, &worst))
+        n++;
+    task_kill(pid);
+
+    if (!n) {
+        printf("input: %s: nothing came back through the loopback\n", name);
+        return;
+    }
+    printf("input: %s: irq to reader %u ns (worst %u), send to reader %u ns, %u rounds\n",
+           name, ns(irq) / n, ns(worst), ns(total) / n, n);
+}
+
+// Wake-up latency of a task blocked in read(): the byte is looped back
+// inside the UART, so no other output may go out meanwhile. The reader
+// stays on core 0 with the benchmark.
+void bench_input(void) {
+    sched_set_active(1);
+    uart_flush();
+    uart_set_loopback(1);
+
+    measure("raw   ", 0, 'x');
+    measure("cooked", UART_COOKED, '\r');   // An empty line, no echo
+
+    uart_set_loopback(0);
+    uart_set_mode(UART_COOKED | UART_ECHO);
+    sched_set_active(cpu_online_mask);
+}
@@ -0,0 +1,145 @@
+#include "bench.h"
+#include "printf.h"
+#include "sched.h"
+#include "smp.h"
+#include "syscall.h"
+#include "user.h"
+#include "mm.h"
+#include "utils.h"
+#include "timer.h"
+#include "ipc.h"
+
+#define BENCH_IPC_ROUNDS    10000
+
+// Set up by bench_ipc: ping sends on chan_ping, pong answers on chan_pong
+static int __user_data chan_ping, chan_pong;
+static volatile unsigned int __user_data ipc_errors;
+
+// EL0 bodies, linked into the user image. Every message is a full
+// IPC_MSG_MAX bytes with the round number in its first word; the
+// zero-copy pair writes it in place in the shared ring, the copying pair
+// hands a stack buffer to the kernel.
+static void __user_text zc_ping(void) {
+    struct ipc_ring *tx = (struct ipc_ring *)chan_map(chan_ping);
+    struct ipc_ring *rx = (struct ipc_ring *)chan_map(chan_pong);
+
+    for (unsigned int i = 0; i < BENCH_IPC_ROUNDS; i++) {
+        struct ipc_msg *m = ipc_reserve(tx);
+
+        *(unsigned int *)m->data = i;
+        m->len = IPC_MSG_MAX;
+        ipc_commit(tx);
+
+        m = ipc_peek(rx);
+        if (*(unsigned int *)m->data != i)
+            ipc_errors++;
+        ipc_release(rx);
+    }
+    exit(0);
+}
+
+static void __user_text zc_pong(void) {
+    struct ipc_ring *rx = (struct ipc_ring *)chan_map(chan_ping);
+    struct ipc_ring *tx = (struct ipc_ring *)chan_map(chan_pong);
+
+    for (unsigned int i = 0; i < BENCH_IPC_ROUNDS; i++) {
+        struct ipc_msg *in = ipc_peek(rx);
+        struct ipc_msg *out = ipc_reserve(tx);
+
+        *(unsigned int *)out->data = *(unsigned int *)in->data;
+        out->len = in->len;
+        ipc_release(rx);
+        ipc_commit(tx);
+    }
+    exit(0);
+}
+
+static void __user_text copy_ping(void) {
+    unsigned int msg[IPC_MSG_MAX / 4];
+
+    for (unsigned int i = 0; i < BENCH_IPC_ROUNDS; i++) {
+        msg[0] = i;
+        chan_send(chan_ping, msg, sizeof(msg));
+        chan_recv(chan_pong, msg, sizeof(msg));
+        if (msg[0] != i)
+            ipc_errors++;
+    }
+    exit(0);
+}
+
+static void __user_text copy_pong(void) {
+    unsigned int msg[IPC_MSG_MAX / 4];
+
+    for (unsigned int i = 0; i < BENCH_IPC_ROUNDS; i++) {
+        chan_recv(chan_ping, msg, sizeof(msg));
+        chan_send(chan_pong, msg, sizeof(msg));
+    }
+    exit(0);
+}
+
+// Generic timer ticks for BENCH_IPC_ROUNDS round trips between a ping and
+// a pong task on the first `cores` cores
+static unsigned long long run(void (*ping)(void), void (*pong)(void), unsigned int cores) {
+    unsigned long long t0, ticks;
+    int pids[2];
+
+    sched_set_active((1 << cores) - 1);
+    memzero((unsigned long)ipc_stats, sizeof(ipc_stats));
+    ipc_errors = 0;
+
+    t0 = timer_count();
+    pids[0] = task_create(pong);
+    pids[1] = task_create(ping);
+    while (task_state(pids[0]) != TASK_ZOMBIE || task_state(pids[1]) != TASK_ZOMBIE)
+        schedule();
+    ticks = timer_count() - t0;
+
+    task_kill(pids[0]);
+    task_kill(pids[1]);
+    return ticks;
+}
+
+static unsigned int round_trip_ns(unsigned long long ticks) {
+    return (unsigned int)udiv64(udiv64(ticks * 1000000000ULL, timer_freq()), BENCH_IPC_ROUNDS);
+}
+
+// Ping-pong of full-size messages over a pair of channels, on one core
+// (every hop is a switch) and on two (both sides can spin): messages/sec,
+// round-trip time and how often each side still had to enter the kernel,
+// for the shared-ring path and for copying through chan_send/chan_recv
+void bench_ipc(void) {
+    chan_ping = ipc_create();
+    chan_pong = ipc_create();
+    if (chan_ping < 0 || chan_pong < 0) {
+        printf("ipc: no channels\n");
+        return;
+    }
+
+    for (unsigned int cores = 1; cores <= 2 && cores <= NR_CPUS; cores++) {
+        unsigned long long ticks;
+        unsigned int calls = 0, sleeps = 0, copies = 0, errors;
+
+        ticks = run(zc_ping, zc_pong, cores);
+        errors = ipc_errors;
+        for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++) {
+            calls += ipc_stats[cpu].futex_calls;
+            sleeps += ipc_stats[cpu].futex_sleeps;
+        }
+        printf("ipc %u core%s zero-copy: %u msgs/s, round trip %u ns, "
+               "%u futex calls (%u sleeps) per 100 round trips, %u errors\n",
+               cores, cores > 1 ? "s" : "", bench_per_sec(2 * BENCH_IPC_ROUNDS, ticks),
+               round_trip_ns(ticks), calls * 100 / BENCH_IPC_ROUNDS,
+               sleeps * 100 / BENCH_IPC_ROUNDS, errors);
+
+        ticks = run(copy_ping, copy_pong, cores);
+        errors = ipc_errors;
+        for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++)
+            copies += ipc_stats[cpu].copies;
+        printf("ipc %u core%s copy:      %u msgs/s, round trip %u ns, "
+               "%u syscalls per 100 round trips, %u errors\n",
+               cores, cores > 1 ? "s" : "", bench_per_sec(2 * BENCH_IPC_ROUNDS, ticks),
+               round_trip_ns(ticks), 2 * copies * 100 / BENCH_IPC_ROUNDS, errors);
+    }
+
+    sched_set_active(cpu_online_mask);
+}
@@ -0,0 +1,116 @@
+#include "bench.h"
+#include "printf.h"
+#include "mm.h"
+#include "kmalloc.h"
+#include "arena.h"
+#include "utils.h"
+#include "pmu.h"
+
+#define BENCH_KMALLOC_PAIRS 1000
+#define BENCH_KMALLOC_BURST 512
+#define BENCH_KMALLOC_SLOTS 256
+#define BENCH_KMALLOC_OPS   20000
+
+static void *objs[BENCH_KMALLOC_BURST];
+static unsigned int sizes[BENCH_KMALLOC_SLOTS];
+
+// Fixed-seed LCG, so every run replays the same workload
+static unsigned int next_rand(unsigned int *seed) {
+    *seed = *seed * 1664525 + 1013904223;
+    return *seed >> 8;
+}
+
+// Sizes spread over every class: a power-of-two range, then a size in it
+static unsigned int mixed_size(unsigned int *seed) {
+    unsigned int range = 16u << (next_rand(seed) % KMALLOC_CLASSES);
+    return 1 + next_rand(seed) % range;
+}
+
+static void latency(void) {
+    struct arena a = ARENA_INIT;
+    unsigned int c0, pair, alloc, free, page, bump;
+
+    kfree(kmalloc(64));     // Warm this core's magazine
+    c0 = pmu_cycles();
+    for (unsigned int i = 0; i < BENCH_KMALLOC_PAIRS; i++)
+        kfree(kmalloc(64));
+    pair = (pmu_cycles() - c0) / BENCH_KMALLOC_PAIRS;
+
+    // Bursts overflow the magazine, so they include refills and drains
+    c0 = pmu_cycles();
+    for (unsigned int i = 0; i < BENCH_KMALLOC_BURST; i++)
+        objs[i] = kmalloc(64);
+    alloc = (pmu_cycles() - c0) / BENCH_KMALLOC_BURST;
+    c0 = pmu_cycles();
+    for (unsigned int i = 0; i < BENCH_KMALLOC_BURST; i++)
+        kfree(objs[i]);
+    free = (pmu_cycles() - c0) / BENCH_KMALLOC_BURST;
+
+    c0 = pmu_cycles();
+    for (unsigned int i = 0; i < BENCH_KMALLOC_PAIRS; i++)
+        free_page(alloc_page());
+    page = (pmu_cycles() - c0) / BENCH_KMALLOC_PAIRS;
+
+    c0 = pmu_cycles();
+    for (unsigned int i = 0; i < BENCH_KMALLOC_BURST; i++)
+        arena_alloc(&a, 64, 8);
+    bump = (pmu_cycles() - c0) / BENCH_KMALLOC_BURST;
+    arena_release(&a);
+
+    printf("kmalloc: 64 B pair %u cycles (magazine), burst of %u: alloc %u free %u cycles\n",
+           pair, BENCH_KMALLOC_BURST, alloc, free);
+    printf("kmalloc: alloc_page+free_page %u cycles, arena_alloc %u cycles\n", page, bump);
+}
+
+// Random allocs and frees over a fixed number of slots, sizes from every
+// class. Utilisation is live requested bytes over the pages the slabs
+// hold at the peak.
+static void mixed(void) {
+    unsigned int seed = 1, live = 0, peak_live = 0;
+    unsigned int base = kmalloc_stats.slab_pages;
+    unsigned int c0, cycles, util;
+    int pages, peak_pages = 0;     // Relative to base; earlier slabs may be freed
+
+    c0 = pmu_cycles();
+    for (unsigned int op = 0; op < BENCH_KMALLOC_OPS; op++) {
+        unsigned int slot = next_rand(&seed) % BENCH_KMALLOC_SLOTS;
+
+        if (sizes[slot]) {
+            kfree(objs[slot]);
+            live -= sizes[slot];
+            sizes[slot] = 0;
+        } else {
+            sizes[slot] = mixed_size(&seed);
+            objs[slot] = kmalloc(sizes[slot]);
+            live += sizes[slot];
+        }
+        pages = (int)(kmalloc_stats.slab_pages - base);
+        if (pages > peak_pages) {
+            peak_pages = pages;
+            peak_live = live;
+        }
+    }
+    cycles = pmu_cycles() - c0;
+
+    for (unsigned int slot = 0; slot < BENCH_KMALLOC_SLOTS; slot++) {
+        if (sizes[slot])
+            kfree(objs[slot]);
+        sizes[slot] = 0;
+    }
+
+    util = peak_pages > 0 ? (unsigned int)udiv64((unsigned long long)peak_live * 1000,
+                                                 peak_pages * PAGE_SIZE) : 0;
+    printf("kmalloc: mixed %u ops over %u slots, %u cycles/op (incl. workload)\n",
+           BENCH_KMALLOC_OPS, BENCH_KMALLOC_SLOTS, cycles / BENCH_KMALLOC_OPS);
+    printf("kmalloc: peak %d slab pages for %u live bytes, utilisation %u.%u%%, %d pages kept after\n",
+           peak_pages, peak_live, util / 10, util % 10, (int)(kmalloc_stats.slab_pages - base));
+}
+
+// kmalloc/kfree latency against the page allocator and the arena, then
+// fragmentation under a mixed-size workload. Runs on core 0 with IRQs as
+// they are; the magazine fast path masks them itself.
+void bench_kmalloc(void) {
+    latency();
+    mixed();
+    printf("kmalloc: %u refills, %u drains\n", kmalloc_stats.refills, kmalloc_stats.drains);
+}
@@ -0,0 +1,72 @@
+#include "bench.h"
+#include "printf.h"
+#include "mm.h"
+#include "sched.h"
+#include "syscall.h"
+#include "user.h"
+#include "utils.h"
+#include "pmu.h"
+#include "timer.h"
+
+#define BENCH_SCHED_MS      100
+#define BENCH_SCHED_SLICE   1000        // us, for the preemption run
+#define BENCH_SCHED_MAX     32
+
+static const int task_counts[] = { 1, 2, 4, 8, 16, BENCH_SCHED_MAX };
+
+// EL0 bodies, linked into the user image
+static void __user_text yield_loop(void) {
+    while (1)
+        sched_yield();
+}
+
+static void __user_text spin_loop(void) {
+    while (1);
+}
+
+// Run n copies of body next to the bench itself (task 0) for a fixed time,
+// calling schedule() whenever round-robin comes back to us
+static void run(const char *name, void (*body)(void), int n) {
+    struct sched_stats *st = &sched_stats[0];
+    int pids[BENCH_SCHED_MAX];
+    unsigned long long t0, ticks;
+    unsigned int c0, cycles, sw, overhead;
+
+    for (int i = 0; i < n; i++)
+        pids[i] = task_create(body);
+
+    memzero((unsigned long)sched_stats, sizeof(sched_stats));
+    c0 = pmu_cycles();
+    t0 = timer_count();
+    do {
+        schedule();
+        ticks = timer_count() - t0;
+    } while (ticks < timer_freq() / 1000 * BENCH_SCHED_MS);
+    cycles = pmu_cycles() - c0;
+
+    for (int i = 0; i < n; i++)
+        task_kill(pids[i]);
+
+    sw = st->switches ? st->switches : 1;
+    overhead = (unsigned int)udiv64((unsigned long long)(st->pick_cycles +
+                                    st->switch_cycles) * 1000, cycles);
+    printf("sched %s %u tasks: %u switches/s, switch %u cycles, pick %u cycles, "
+           "overhead %u.%u%%\n", name, n, bench_per_sec(st->switches, ticks),
+           st->switch_cycles / sw, st->pick_cycles / st->schedules,
+           overhead / 10, overhead % 10);
+}
+
+// Context-switch latency with tasks that yield back-to-back, then the cost
+// of timer preemption between tasks that never yield, as the task count
+// grows. Everything stays on core 0; bench_smp covers the other cores.
+void bench_sched(void) {
+    sched_set_active(1);
+    for (unsigned int i = 0; i < sizeof(task_counts) / sizeof(task_counts[0]); i++)
+        run("yield  ", yield_loop, task_counts[i]);
+
+    sched_set_slice(BENCH_SCHED_SLICE);
+    for (unsigned int i = 0; i < sizeof(task_counts) / sizeof(task_counts[0]); i++)
+        run("preempt", spin_loop, task_counts[i]);
+    sched_set_slice(SCHED_SLICE_US);
+    sched_set_active(cpu_online_mask);
+}
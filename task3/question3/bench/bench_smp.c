@@ -0,0 +1,73 @@
+#include "bench.h"
+#include "printf.h"
+#include "sched.h"
+#include "smp.h"
+#include "syscall.h"
+#include "user.h"
+#include "mm.h"
+#include "utils.h"
+#include "timer.h"
+
+#define BENCH_SMP_TASKS     8
+#define BENCH_SMP_WORK      (8 * 1000 * 1000)   // Loop iterations over all tasks
+
+// EL0 body, linked into the user image: a fixed share of CPU-bound work
+static void __user_text work(void) {
+    volatile unsigned int acc = 0;
+
+    for (unsigned int i = 0; i < BENCH_SMP_WORK / BENCH_SMP_TASKS; i++)
+        acc += i * i;
+    exit(0);
+}
+
+// Wall time for the whole job with the first `cores` cores allowed to run it
+static unsigned long long run(unsigned int cores) {
+    int pids[BENCH_SMP_TASKS];
+    unsigned long long t0, ticks;
+    unsigned int steals = 0;
+    int done;
+
+    sched_set_active((1 << cores) - 1);
+    memzero((unsigned long)sched_stats, sizeof(sched_stats));
+
+    t0 = timer_count();
+    for (int i = 0; i < BENCH_SMP_TASKS; i++)
+        pids[i] = task_create(work);
+    do {
+        schedule();
+        done = 1;
+        for (int i = 0; i < BENCH_SMP_TASKS; i++)
+            if (pids[i] > 0 && task_state(pids[i]) != TASK_ZOMBIE)
+                done = 0;
+    } while (!done);
+    ticks = timer_count() - t0;
+
+    for (int i = 0; i < BENCH_SMP_TASKS; i++)
+        task_kill(pids[i]);
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++)
+        steals += sched_stats[cpu].steals;
+
+    printf("smp %u cores: %u us, %u steals", cores, bench_us(ticks), steals);
+    return ticks;
+}
+
+// The same CPU-bound job split over BENCH_SMP_TASKS tasks, on 1 to 4 cores
+void bench_smp(void) {
+    unsigned long long base = 0;
+
+    for (unsigned int cores = 1; cores <= NR_CPUS; cores++) {
+        unsigned long long ticks;
+        unsigned int x10;
+
+        if (!(cpu_online_mask & (1 << (cores - 1)))) {
+            printf("smp %u cores: core %u offline\n", cores, cores - 1);
+            break;
+        }
+        ticks = run(cores);
+        if (cores == 1)
+            base = ticks;
+        x10 = (unsigned int)udiv64(base * 10, (unsigned int)ticks);
+        printf(", speedup x%u.%u\n", x10 / 10, x10 % 10);
+    }
+    sched_set_active(cpu_online_mask);
+}
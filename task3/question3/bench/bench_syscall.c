@@ -0,0 +1,35 @@
+#include "bench.h"
+#include "printf.h"
+#include "syscall.h"
+#include "pmu.h"
+
+#define BENCH_SYSCALL_ITERS 1000
+
+// Round trip of one syscall number: best single call and average over a run
+static void run(const char *name, int nr) {
+    unsigned int best = 0xFFFFFFFF;
+    unsigned int c0, c1, total;
+
+    for (int i = 0; i < BENCH_SYSCALL_ITERS; i++) {
+        c0 = pmu_cycles();
+        syscall3(nr, 0, 0, 0);
+        c1 = pmu_cycles();
+        if (c1 - c0 < best)
+            best = c1 - c0;
+    }
+
+    c0 = pmu_cycles();
+    for (int i = 0; i < BENCH_SYSCALL_ITERS; i++)
+        syscall3(nr, 0, 0, 0);
+    total = pmu_cycles() - c0;
+
+    printf("syscall %s: %u cycles best, %u cycles avg\n", name, best,
+           total / BENCH_SYSCALL_ITERS);
+}
+
+// Trap-path latency on the Cortex-A7 cycle counter
+void bench_syscall(void) {
+    run("null  ", SYS_NULL);
+    run("getpid", SYS_GETPID);
+    run("enosys", NR_SYSCALLS - 1);
+}
@@ -0,0 +1,53 @@
+#include "bench.h"
+#include "printf.h"
+#include "translation.h"
+#include "pmu.h"
+
+// 64 MB of RAM starting at the first supersection: four supersections, or
+// 64 sections once split
+#define BENCH_TLB_BASE      0x01000000
+#define BENCH_TLB_MB        64
+#define BENCH_TLB_ROUNDS    64
+
+// One load per MB, each at a different cache line so the data stays in L1
+// and the TLB is what misses
+static void stride(unsigned int *cycles, unsigned int *refills) {
+    unsigned int c0, r0;
+    unsigned int sum = 0;
+
+    c0 = pmu_cycles();
+    r0 = pmu_event_read(PMU_CNT_L1D_TLB_REFILL);
+    for (unsigned int r = 0; r < BENCH_TLB_ROUNDS; r++)
+        for (unsigned int mb = 0; mb < BENCH_TLB_MB; mb++)
+            sum += *(volatile unsigned int *)(BENCH_TLB_BASE + (mb << 20) + ((mb & 63) << 6));
+    *refills = pmu_event_read(PMU_CNT_L1D_TLB_REFILL) - r0;
+    *cycles = pmu_cycles() - c0;
+    (void)sum;
+}
+
+static void report(const char *mapping, unsigned int cycles, unsigned int refills) {
+    unsigned int loads = BENCH_TLB_ROUNDS * BENCH_TLB_MB;
+
+    printf("tlb: %s: %u cycles/load, %u TLB refills per 1000 loads\n", mapping,
+           cycles / loads, refills * 1000 / loads);
+}
+
+// Same walk over 64 MB with the region mapped as 16 MB supersections, then
+// split into 1 MB sections
+void bench_tlb(void) {
+    unsigned int *l1 = get_translation_table();
+    unsigned int cycles, refills;
+
+    stride(&cycles, &refills);      // Warm the caches
+    stride(&cycles, &refills);
+    report("supersections", cycles, refills);
+
+    for (unsigned int mb = 0; mb < BENCH_TLB_MB; mb += SUPERSECTION_ENTRIES)
+        split_supersection(l1, BENCH_TLB_BASE + (mb << 20));
+    stride(&cycles, &refills);
+    stride(&cycles, &refills);
+    report("sections     ", cycles, refills);
+
+    for (unsigned int mb = 0; mb < BENCH_TLB_MB; mb += SUPERSECTION_ENTRIES)
+        merge_supersection(l1, BENCH_TLB_BASE + (mb << 20));
+}
@@ -0,0 +1,72 @@
+#include "bench.h"
+#include "printf.h"
+#include "mini_uart.h"
+#include "pmu.h"
+#include "timer.h"
+#include "utils.h"
+
+#define BENCH_UART_LINES    64
+
+static const char line[] = "uart bench: the quick brown fox jumps over the lazy dog 0123456789\r\n";
+
+// Driver cycles per KB sent
+static unsigned int per_kb(unsigned int cycles, unsigned int bytes) {
+    return (unsigned int)udiv64((unsigned long long)cycles * 1024, bytes);
+}
+
+// TX throughput and CPU cycles spent in the driver: polled, IRQ-driven,
+// and DMA where the CPU only widens bytes into blocks and chains them
+void bench_uart(void) {
+    unsigned int len = sizeof(line) - 1;
+    unsigned int bytes = BENCH_UART_LINES * len;
+    unsigned long long t0, poll_ticks, irq_ticks, dma_ticks;
+    unsigned int c0, irq0, poll_cycles, driver_cycles = 0, dma_cycles, irqs;
+    struct uart_stats before;
+
+    uart_flush();
+
+    // Before: one busy-waiting MMIO write per byte
+    t0 = timer_count();
+    c0 = pmu_cycles();
+    for (int i = 0; i < BENCH_UART_LINES; i++)
+        for (unsigned int j = 0; j < len; j++)
+            uart_send_polled(line[j]);
+    poll_cycles = pmu_cycles() - c0;
+    poll_ticks = timer_count() - t0;
+
+    // After: queue whole lines and let the TX interrupt drain the FIFO.
+    // Driver time is time inside uart_write plus time in the IRQ handler;
+    // IRQs taken while uart_write runs are only counted once.
+    before = uart_stats;
+    t0 = timer_count();
+    for (int i = 0; i < BENCH_UART_LINES; i++) {
+        irq0 = uart_stats.irq_cycles;
+        c0 = pmu_cycles();
+        uart_write(line, len);
+        driver_cycles += (pmu_cycles() - c0) - (uart_stats.irq_cycles - irq0);
+    }
+    uart_flush();
+    irq_ticks = timer_count() - t0;
+    driver_cycles += uart_stats.irq_cycles - before.irq_cycles;
+    irqs = uart_stats.irqs - before.irqs;
+
+    // DMA: waits for free blocks are outside the counted cycles
+    before = uart_stats;
+    t0 = timer_count();
+    uart_dma_begin();
+    for (int i = 0; i < BENCH_UART_LINES; i++)
+        uart_dma_write(line, len);
+    uart_dma_end();
+    dma_ticks = timer_count() - t0;
+    dma_cycles = uart_stats.dma_cycles - before.dma_cycles;
+
+    printf("uart polled: %u bytes in %u us, %u bytes/s, %u cycles in driver, %u/KB\n",
+           bytes, bench_us(poll_ticks), bench_per_sec(bytes, poll_ticks), poll_cycles,
+           per_kb(poll_cycles, bytes));
+    printf("uart irq:    %u bytes in %u us, %u bytes/s, %u cycles in driver, %u/KB, %u irqs\n",
+           bytes, bench_us(irq_ticks), bench_per_sec(bytes, irq_ticks), driver_cycles,
+           per_kb(driver_cycles, bytes), irqs);
+    printf("uart dma:    %u bytes in %u us, %u bytes/s, %u cycles in driver, %u/KB, %u irqs\n",
+           bytes, bench_us(dma_ticks), bench_per_sec(bytes, dma_ticks), dma_cycles,
+           per_kb(dma_cycles, bytes), uart_stats.dma_irqs - before.dma_irqs);
+}
@@ -0,0 +1,58 @@
+#include "bench.h"
+#include "printf.h"
+#include "mini_uart.h"
+#include "syscall.h"
+#include "user.h"
+#include "pmu.h"
+
+#define BENCH_WRITE_LINES   12      // 12 * 64 bytes stays inside the TX ring
+#define BENCH_WRITE_ROUNDS  8
+
+// 64-byte log line; placed in the user image so write() accepts it
+static const char line[] __user_rodata = "write bench: 0123456789abcdefghijklmnopqrstuvwxyz 0123456789ab\r\n";
+
+// Old style: one trap per 4-byte chunk, as the question2 user.c did
+static void log_chunked(void) {
+    for (unsigned int off = 0; off < sizeof(line) - 1; off += 4)
+        write(STDOUT_FILENO, line + off, 4);
+}
+
+static void log_line(void) {
+    write(STDOUT_FILENO, line, sizeof(line) - 1);
+}
+
+// Same line split into prefix/body/eol, still one trap
+static void log_writev(void) {
+    static const struct iovec iov[3] __user_rodata = {
+        { line, 13 },
+        { line + 13, sizeof(line) - 1 - 15 },
+        { line + sizeof(line) - 3, 2 },
+    };
+    writev(STDOUT_FILENO, iov, 3);
+}
+
+static void run(const char *name, void (*fn)(void)) {
+    unsigned int bytes = BENCH_WRITE_LINES * (sizeof(line) - 1);
+    unsigned int best = 0xFFFFFFFF;
+
+    for (int r = 0; r < BENCH_WRITE_ROUNDS; r++) {
+        // Drain first so only the trap and the queue copy are timed
+        uart_flush();
+        unsigned int c0 = pmu_cycles();
+        for (int i = 0; i < BENCH_WRITE_LINES; i++)
+            fn();
+        unsigned int cycles = pmu_cycles() - c0;
+        if (cycles < best)
+            best = cycles;
+    }
+    uart_flush();
+    printf("write %s: %u cycles/line, %u cycles/100 bytes\n", name,
+           best / BENCH_WRITE_LINES, best * 100 / bytes);
+}
+
+// Cycles per byte for logging through the write syscall path
+void bench_write(void) {
+    run("4-byte chunks", log_chunked);
+    run("one per line ", log_line);
+    run("writev       ", log_writev);
+}
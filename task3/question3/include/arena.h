@@ -0,0 +1,27 @@
+#pragma once
+
+/*
+ * Bump allocator for groups of objects that die together, such as
+ * boot-time setup or one benchmark run: allocation only moves a pointer,
+ * and arena_release() hands every chunk back at once. An arena has a
+ * single owner and no lock.
+ */
+
+#define ARENA_CHUNK_ORDER   4           // 64 KB chunks from alloc_pages
+
+#ifndef __ASSEMBLER__
+
+struct arena_chunk;
+
+struct arena {
+    struct arena_chunk *chunks;         // Most recent first
+    unsigned int cur, end;              // Free space in the newest chunk
+    unsigned int bytes;                 // Handed out since the last release
+};
+
+#define ARENA_INIT  { 0, 0, 0, 0 }
+
+void *arena_alloc(struct arena *a, unsigned int size, unsigned int align);
+void arena_release(struct arena *a);
+
+#endif /* __ASSEMBLER__ */
@@ -0,0 +1,32 @@
+#pragma once
+
+/*
+ * 8-bit ASIDs for the per-process translation tables. User mappings are
+ * non-global, so TLB entries of different processes can coexist and a
+ * switch only rewrites TTBR0 and CONTEXTIDR. ASID 0 is reserved for the
+ * kernel-only table. When all 255 are handed out, the generation number
+ * in the upper bits of context_id moves on and every core flushes its TLB
+ * once before it next installs a process.
+ */
+
+#define ASID_BITS           8
+#define NR_ASIDS            (1 << ASID_BITS)
+#define ASID_MASK           (NR_ASIDS - 1)
+
+#ifndef __ASSEMBLER__
+
+struct task;
+
+struct asid_stats {
+    unsigned int allocs;        // New ASIDs handed out
+    unsigned int rollovers;     // Generations used up
+    unsigned int flushes;       // Local TLB flushes done by switch_mm
+};
+
+extern struct asid_stats asid_stats;
+
+void switch_mm(struct task *next);
+void asid_set_enabled(int enabled);
+void flush_tlb_asid(void);
+
+#endif /* __ASSEMBLER__ */
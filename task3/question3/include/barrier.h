@@ -0,0 +1,5 @@
+#pragma once
+
+#define dmb()   asm volatile("dmb" ::: "memory")
+#define dsb()   asm volatile("dsb" ::: "memory")
+#define isb()   asm volatile("isb" ::: "memory")
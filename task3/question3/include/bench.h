@@ -0,0 +1,27 @@
+#pragma once
+
+// Benchmarks are built only with `make BENCH=1` and run from kernel_main
+
+void bench_run_all(void);
+void bench_boot(void);
+void bench_uart(void);
+void bench_write(void);
+void bench_syscall(void);
+void bench_cache(void);
+void bench_mem(void);
+void bench_kmalloc(void);
+void bench_tlb(void);
+void bench_sched(void);
+void bench_asid(void);
+void bench_fault(void);
+void bench_exec(void);
+void bench_input(void);
+void bench_ipc(void);
+void bench_smp(void);
+void bench_idle(void);
+
+// Helpers shared by bench/*.c
+unsigned int bench_us(unsigned long long ticks);
+unsigned int bench_per_sec(unsigned int count, unsigned long long ticks);
+unsigned int bench_mb_per_sec(unsigned int bytes, unsigned long long ticks);
+void *bench_alloc(unsigned int size, unsigned int align);
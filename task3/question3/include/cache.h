@@ -0,0 +1,16 @@
+#pragma once
+
+void cache_init(void);
+void cache_enable(void);
+void cache_disable(void);
+int cache_enabled(void);
+
+void icache_invalidate_all(void);
+void dcache_invalidate_all(void);
+void dcache_clean_invalidate_all(void);
+void dcache_invalidate_l1(void);     // Boot-time only, see cache.S
+
+// Maintenance by MVA to the point of coherency, for buffers shared with DMA
+void dcache_clean_range(unsigned int start, unsigned int len);
+void dcache_invalidate_range(unsigned int start, unsigned int len);
+void dcache_clean_invalidate_range(unsigned int start, unsigned int len);
@@ -0,0 +1,19 @@
+#pragma once
+
+// One BCM2835 DMA control block; the engine needs them 32-byte aligned
+struct dma_cb {
+    unsigned int ti;
+    unsigned int source_ad;
+    unsigned int dest_ad;
+    unsigned int txfr_len;
+    unsigned int stride;
+    unsigned int nextconbk;
+    unsigned int reserved[2];
+} __attribute__((aligned(32)));
+
+unsigned int dma_bus_addr(const void *p);
+unsigned int dma_bus_periph(unsigned int addr);
+void dma_channel_init(unsigned int ch);
+void dma_start(unsigned int ch, const struct dma_cb *cb);
+int dma_done(unsigned int ch);
+void dma_ack(unsigned int ch);
@@ -0,0 +1,44 @@
+#pragma once
+
+// The subset of ELF32 the program loader (exec.c) reads
+
+#define EI_NIDENT       16
+#define ELFMAG          0x464C457F  // "\177ELF", little-endian word
+#define ELFCLASS32      1
+#define ELFDATA2LSB     1
+#define ET_EXEC         2
+#define EM_ARM          40
+
+#define PT_LOAD         1
+
+#define PF_X            (1 << 0)
+#define PF_W            (1 << 1)
+#define PF_R            (1 << 2)
+
+struct elf32_ehdr {
+    unsigned char e_ident[EI_NIDENT];
+    unsigned short e_type;
+    unsigned short e_machine;
+    unsigned int e_version;
+    unsigned int e_entry;
+    unsigned int e_phoff;
+    unsigned int e_shoff;
+    unsigned int e_flags;
+    unsigned short e_ehsize;
+    unsigned short e_phentsize;
+    unsigned short e_phnum;
+    unsigned short e_shentsize;
+    unsigned short e_shnum;
+    unsigned short e_shstrndx;
+};
+
+struct elf32_phdr {
+    unsigned int p_type;
+    unsigned int p_offset;
+    unsigned int p_vaddr;
+    unsigned int p_paddr;
+    unsigned int p_filesz;
+    unsigned int p_memsz;
+    unsigned int p_flags;
+    unsigned int p_align;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+/*
+ * EL0 programs come from the initramfs: separately linked ELF files that
+ * the makefile packs (tools/mkinitramfs.py) and src/initramfs.S embeds.
+ * The archive is a header, an entry table, then each file on a page
+ * boundary, so the pages of a file can be mapped as they are.
+ */
+#define INITRAMFS_MAGIC     0x53465249  // "IRFS"
+#define INITRAMFS_NAME_MAX  24
+#define INITRAMFS_MAX       16
+
+struct initramfs_header {
+    unsigned int magic;
+    unsigned int count;
+};
+
+struct initramfs_entry {
+    char name[INITRAMFS_NAME_MAX];      // NUL-terminated
+    unsigned int offset;                // From the archive start, page aligned
+    unsigned int size;
+};
+
+/*
+ * A loaded program: its PT_LOAD segments, faulted in lazily (fault.c).
+ * Read-only segments map the archive's own pages, shared by every
+ * instance; writable ones get private pages filled from the file.
+ * Parsed once per program and never freed.
+ */
+#define USER_IMAGE_SEGS     4
+
+struct user_segment {
+    unsigned int start, end;            // Page-aligned range covered
+    unsigned int vaddr;                 // First byte backed by the file
+    unsigned int file;                  // Kernel address of that byte
+    unsigned int filesz;
+    unsigned int memsz;
+    unsigned int flags;                 // PF_R | PF_W | PF_X
+};
+
+struct user_image {
+    const char *name;
+    unsigned int entry;
+    unsigned int nsegs;
+    unsigned int text_pages;            // Shared pages, for the benchmarks
+    struct user_segment segs[USER_IMAGE_SEGS];
+};
+
+struct svc_frame;
+
+void initramfs_init(void);
+const struct user_image *image_lookup(const char *name);
+const struct user_segment *image_segment(const struct user_image *img, unsigned int va);
+void exec_image(struct svc_frame *f, const struct user_image *img);
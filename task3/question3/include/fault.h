@@ -0,0 +1,53 @@
+#pragma once
+
+#include "smp.h"
+
+// DFSR/IFSR fault status, with FS[4] (bit 10) moved down next to FS[3:0]
+#define FSR_STATUS(fsr)         (((fsr) & 0xF) | (((fsr) >> 6) & 0x10))
+#define FSR_WNR                 (1 << 11)   // DFSR only: the access was a write
+
+// handle_user_fault access bits
+#define FAULT_WRITE             (1 << 0)
+#define FAULT_EXEC              (1 << 1)
+
+#define FS_ALIGNMENT            0x01
+#define FS_TRANSLATION_SECTION  0x05
+#define FS_TRANSLATION_PAGE     0x07
+#define FS_DOMAIN_SECTION       0x09
+#define FS_DOMAIN_PAGE          0x0B
+#define FS_PERMISSION_SECTION   0x0D
+#define FS_PERMISSION_PAGE      0x0F
+
+#ifndef __ASSEMBLER__
+
+// Built on the SVC stack by the abort vectors (vectors.S), lowest address
+// first: the interrupted registers, then what SRS pushed
+struct abort_frame {
+    unsigned int r[13];
+    unsigned int lr;            // lr_svc
+    unsigned int pc;            // The faulting instruction
+    unsigned int cpsr;
+};
+
+struct fault_stats {
+    unsigned int zero_fills;    // Demand-zero pages mapped
+    unsigned int zero_cycles;
+    unsigned int cow_copies;    // Writes to a shared page that copied it
+    unsigned int cow_reuses;    // ... to one no longer shared, made writable
+    unsigned int cow_cycles;
+    unsigned int forks;
+    unsigned int fork_pages;    // Pages shared copy-on-write by fork
+    unsigned int fork_cycles;
+    unsigned int kills;         // Tasks ended by a bad access
+    unsigned int file_maps;     // Program pages mapped from the initramfs
+    unsigned int file_copies;   // ... copied into a private frame
+    unsigned int file_cycles;
+};
+
+extern struct fault_stats fault_stats[NR_CPUS];
+
+int handle_user_fault(unsigned int va, int access);
+void do_data_abort(struct abort_frame *f);
+void do_prefetch_abort(struct abort_frame *f);
+
+#endif /* __ASSEMBLER__ */
@@ -0,0 +1,116 @@
+#pragma once
+
+/*
+ * Zero-copy IPC: a channel is one page holding a single-producer,
+ * single-consumer ring of fixed-size messages. Both processes map it
+ * (chan_map) and build messages in place, so the kernel is entered only
+ * to sleep on a full or empty ring and to wake the other side, both
+ * through futex() on the ring's indices.
+ *
+ * head is written only by the producer and tail only by the consumer,
+ * each on its own cache line; the waiting flags sit with the side that
+ * sets them. A side about to sleep sets its flag, re-checks the ring and
+ * only then calls FUTEX_WAIT with the index it saw, so a commit landing in
+ * between either shows up in the re-check or makes the wait return.
+ */
+
+#include "syscall.h"
+#include "barrier.h"
+
+#define IPC_MAX             16          // Channels, within USER_IPC_SIZE
+#define IPC_SLOTS           32          // Power of two
+#define IPC_MSG_SIZE        64
+#define IPC_MSG_MAX         (IPC_MSG_SIZE - 4)
+#define IPC_SPIN            100         // Ring re-checks before sleeping
+#define IPC_LINE            64
+
+#ifndef __ASSEMBLER__
+
+struct ipc_msg {
+    unsigned int len;
+    unsigned char data[IPC_MSG_MAX];
+};
+
+struct ipc_ring {
+    volatile unsigned int head;         // Next slot to fill: producer
+    volatile unsigned int tx_waiting;   // Producer sleeps on tail
+    unsigned char pad0[IPC_LINE - 8];
+    volatile unsigned int tail;         // Next slot to drain: consumer
+    volatile unsigned int rx_waiting;   // Consumer sleeps on head
+    unsigned char pad1[IPC_LINE - 8];
+    struct ipc_msg slot[IPC_SLOTS];
+};
+
+/*
+ * EL0 side, always inlined like the syscall wrappers so that __user_text
+ * code can use it. A producer calls ipc_reserve, fills the slot and calls
+ * ipc_commit; a consumer calls ipc_peek, reads the slot and calls
+ * ipc_release. Both block while the ring is full or empty.
+ */
+__syscall_inline struct ipc_msg *ipc_reserve(struct ipc_ring *r) {
+    unsigned int head = r->head;
+
+    for (unsigned int spin = 0; head - r->tail == IPC_SLOTS; spin++) {
+        if (spin < IPC_SPIN)
+            continue;
+        r->tx_waiting = 1;
+        dmb();
+        if (head - r->tail == IPC_SLOTS)
+            futex(&r->tail, FUTEX_WAIT, head - IPC_SLOTS);
+    }
+    r->tx_waiting = 0;
+    dmb();          // Read tail before reusing its slot
+    return &r->slot[head & (IPC_SLOTS - 1)];
+}
+
+__syscall_inline void ipc_commit(struct ipc_ring *r) {
+    dmb();          // The message before the index
+    r->head = r->head + 1;
+    dmb();          // The index before the flag
+    if (r->rx_waiting)
+        futex(&r->head, FUTEX_WAKE, 1);
+}
+
+__syscall_inline struct ipc_msg *ipc_peek(struct ipc_ring *r) {
+    unsigned int tail = r->tail;
+
+    for (unsigned int spin = 0; r->head == tail; spin++) {
+        if (spin < IPC_SPIN)
+            continue;
+        r->rx_waiting = 1;
+        dmb();
+        if (r->head == tail)
+            futex(&r->head, FUTEX_WAIT, tail);
+    }
+    r->rx_waiting = 0;
+    dmb();          // Read head before the message
+    return &r->slot[tail & (IPC_SLOTS - 1)];
+}
+
+__syscall_inline void ipc_release(struct ipc_ring *r) {
+    dmb();          // Done with the message before freeing it
+    r->tail = r->tail + 1;
+    dmb();
+    if (r->tx_waiting)
+        futex(&r->tail, FUTEX_WAKE, 1);
+}
+
+// Kernel side (ipc.c)
+#include "smp.h"
+
+struct ipc_stats {
+    unsigned int futex_calls;   // FUTEX_WAIT and FUTEX_WAKE
+    unsigned int futex_sleeps;  // FUTEX_WAITs that slept
+    unsigned int copies;        // Messages through chan_send/chan_recv
+};
+
+extern struct ipc_stats ipc_stats[NR_CPUS];
+
+int ipc_create(void);
+int ipc_map(int id);
+int ipc_send(int id, const void *buf, unsigned int len);
+int ipc_recv(int id, void *buf, unsigned int len);
+int futex_wait(unsigned int uaddr, unsigned int val);
+int futex_wake(unsigned int uaddr);
+
+#endif /* __ASSEMBLER__ */
@@ -0,0 +1,30 @@
+#pragma once
+
+void irq_init(void);
+void handle_irq(void);
+
+static inline void enable_irq(void) {
+    asm volatile("cpsie i" ::: "memory");
+}
+
+static inline void disable_irq(void) {
+    asm volatile("cpsid i" ::: "memory");
+}
+
+// Mask IRQs and return the previous CPSR so nested sections restore correctly
+static inline unsigned int irq_save(void) {
+    unsigned int flags;
+    asm volatile("mrs %0, cpsr\n"
+                 "cpsid i" : "=r"(flags) :: "memory");
+    return flags;
+}
+
+static inline void irq_restore(unsigned int flags) {
+    asm volatile("msr cpsr_c, %0" :: "r"(flags) : "memory");
+}
+
+static inline int irqs_disabled(void) {
+    unsigned int cpsr;
+    asm volatile("mrs %0, cpsr" : "=r"(cpsr));
+    return (cpsr >> 7) & 1;
+}
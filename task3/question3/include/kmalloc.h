@@ -0,0 +1,35 @@
+#pragma once
+
+/*
+ * Kernel object allocator. Sizes up to KMALLOC_MAX come from one slab
+ * cache per power-of-two class; objects are aligned to their class size,
+ * so a 1 KB second-level table is 1 KB aligned. Each core keeps a small
+ * magazine of free objects per class, so the common kmalloc/kfree pair
+ * only masks IRQs and takes no lock. Larger sizes get whole pages.
+ */
+
+#include "smp.h"
+
+#define KMALLOC_MIN_SHIFT   4           // 16 bytes
+#define KMALLOC_MAX_SHIFT   11          // 2 KB
+#define KMALLOC_MAX         (1 << KMALLOC_MAX_SHIFT)
+#define KMALLOC_CLASSES     (KMALLOC_MAX_SHIFT - KMALLOC_MIN_SHIFT + 1)
+
+#define MAGAZINE_SIZE       16          // Objects cached per core and class
+
+#ifndef __ASSEMBLER__
+
+struct kmalloc_stats {
+    unsigned int slab_pages;    // Frames held by slabs
+    unsigned int large_pages;   // Frames handed out whole
+    unsigned int refills;       // Magazine refills from the slabs
+    unsigned int drains;        // ... and returns to them
+};
+
+extern struct kmalloc_stats kmalloc_stats;
+
+void *kmalloc(unsigned int size);
+void *kzalloc(unsigned int size);
+void kfree(void *p);
+
+#endif /* __ASSEMBLER__ */
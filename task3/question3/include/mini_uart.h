@@ -4,3 +4,47 @@ void uart_init();
 void uart_send(char c);
 char uart_recv();
 void uart_puts(const char *s);
+void uart_write(const char *buf, unsigned int len);
+void uart_flush(void);
+void uart_send_polled(char c);
+void uart_handle_irq(void);
+
+// Console input for tasks (read and poll syscalls); see the line
+// discipline in mini_uart.c
+#define UART_COOKED     (1 << 0)    // Line editing, reads return whole lines
+#define UART_ECHO       (1 << 1)
+
+unsigned int uart_read(char *buf, unsigned int len);
+unsigned int uart_poll(unsigned int events, int block, unsigned long long deadline);
+void uart_set_mode(unsigned int mode);
+void uart_set_loopback(int on);
+
+// Binary output through the DMA engine that must not interleave with
+// anything else; uart_dma_irq is the channel's completion interrupt
+void uart_dma_begin(void);
+void uart_dma_write(const void *buf, unsigned int len);
+void uart_dma_end(void);
+void uart_dma_irq(void);
+
+#define UART_DMA_CHANNEL    5
+
+// Driver counters, read by the benchmarks
+struct uart_stats {
+    unsigned int tx_bytes;
+    unsigned int rx_bytes;
+    unsigned int rx_dropped;    // No room in the line or in rx_ring
+    unsigned int rx_wakeups;    // Reads that had to sleep
+    unsigned long long rx_ready_ticks;  // Last input made readable (IRQ)
+    unsigned long long rx_resume_ticks; // ... and its reader running again
+    unsigned int irqs;
+    unsigned int irq_cycles;
+    unsigned int dma_bytes;
+    unsigned int dma_irqs;
+    unsigned int dma_cycles;     // Filling blocks, chaining and reaping
+};
+
+extern struct uart_stats uart_stats;
+
+// Generic timer count when the first byte reached the FIFO: boot time, as
+// the count starts from zero at reset under QEMU
+extern unsigned long long uart_first_tx_ticks;
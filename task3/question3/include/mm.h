@@ -1,4 +1,43 @@
 #pragma once
 
+#define PAGE_SHIFT          12
+#define PAGE_SIZE           (1 << PAGE_SHIFT)
+#define PAGE_ALIGN(x)       (((x) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1))
+
+// RAM handed to the page allocator ends where the peripheral window starts
+#define RAM_END             0x3F000000
+
+// EL0 stack lives above RAM so it never aliases the kernel identity map
+#define USER_STACK_TOP      0x80000000
+
+// Per-process windows, zero-filled a page at a time on first touch (see
+// fault.c): the EL0 stack below USER_STACK_TOP and a heap at USER_HEAP_BASE
+#define USER_STACK_SIZE     0x00100000
+#define USER_HEAP_BASE      0x70000000
+#define USER_HEAP_SIZE      0x00400000
+
+// Where initramfs programs are linked (user/user.ld); their PT_LOAD
+// segments must lie inside this window
+#define USER_IMAGE_BASE     0x60000000
+#define USER_IMAGE_SIZE     0x01000000
+
+// IPC channel pages (ipc.c), channel n at USER_IPC_BASE + n pages. Shared
+// and writable in every process that maps them, fork included
+#define USER_IPC_BASE       0x6F000000
+#define USER_IPC_SIZE       0x00100000
+
 void mmu_init(void);
-void protect_uart_memory(void);
+void memzero(unsigned long src, unsigned long n);     // common/src/string.S
+
+// Physical page frame allocator (page_alloc.c)
+void page_alloc_init(unsigned int start, unsigned int end);
+unsigned int alloc_page(void);
+void free_page(unsigned int pa);
+unsigned int alloc_pages(unsigned int order);
+void free_pages(unsigned int pa, unsigned int order);
+void page_get(unsigned int pa);
+void page_put(unsigned int pa);
+unsigned int page_refs(unsigned int pa);
+void page_set_tag(unsigned int pa, unsigned int tag);
+unsigned int page_tag(unsigned int pa);
+unsigned int pages_free(void);
@@ -4,6 +4,9 @@
 
 // Base addresses - update with your actual addresses
 #define PERIPHERAL_BASE     0x3F000000  // BCM2835/BCM2836 Raspberry Pi peripheral base
-#define UART_BASE           (PERIPHERAL_BASE + 0x215000)  // Mini UART base address
+#define UART_BASE           (PERIPHERAL_BASE + 0x201000)  // PL011 UART0 base address (QEMU -serial stdio)
 
-#endif /* PERIPHERALS_H */
\ No newline at end of file
+// BCM2836 ARM-local peripherals (per-core timers, mailboxes, interrupt routing)
+#define LOCAL_PERIPHERAL_BASE   0x40000000
+
+#endif /* PERIPHERALS_H */
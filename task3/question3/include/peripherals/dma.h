@@ -0,0 +1,42 @@
+#ifndef _P_DMA_H
+#define _P_DMA_H
+
+#include "peripherals/base.h"
+
+// BCM2835 DMA controller: channels 0-14 at 0x100 strides
+#define DMA_BASE            (PERIPHERAL_BASE+0x00007000)
+#define DMA_CS(n)           (DMA_BASE+0x100*(n)+0x00)
+#define DMA_CONBLK_AD(n)    (DMA_BASE+0x100*(n)+0x04)
+#define DMA_DEBUG(n)        (DMA_BASE+0x100*(n)+0x20)
+#define DMA_INT_STATUS      (DMA_BASE+0xFE0)
+#define DMA_ENABLE          (DMA_BASE+0xFF0)
+
+// DMA_CS bits
+#define DMA_CS_ACTIVE       (1 << 0)
+#define DMA_CS_END          (1 << 1)    // Write 1 to clear
+#define DMA_CS_INT          (1 << 2)    // Write 1 to clear
+#define DMA_CS_ERROR        (1 << 8)
+#define DMA_CS_PRIORITY(x)  ((x) << 16)
+#define DMA_CS_PANIC_PRIORITY(x) ((x) << 20)
+#define DMA_CS_WAIT_WRITES  (1 << 28)
+#define DMA_CS_RESET        (1u << 31)
+
+// Control block transfer information (TI)
+#define DMA_TI_INTEN        (1 << 0)
+#define DMA_TI_WAIT_RESP    (1 << 3)
+#define DMA_TI_DEST_INC     (1 << 4)
+#define DMA_TI_DEST_DREQ    (1 << 6)
+#define DMA_TI_SRC_INC      (1 << 8)
+#define DMA_TI_SRC_DREQ     (1 << 10)
+#define DMA_TI_PERMAP(x)    ((x) << 16)
+
+// Peripheral DREQ lines (TI.PERMAP)
+#define DMA_DREQ_UART_TX    12
+#define DMA_DREQ_UART_RX    14
+
+// The DMA engine sees the VideoCore bus: peripherals at 0x7E000000 and RAM
+// through the L2-bypassing alias at 0xC0000000
+#define BUS_PERIPHERAL_BASE 0x7E000000
+#define BUS_RAM_UNCACHED    0xC0000000
+
+#endif  /*_P_DMA_H */
@@ -0,0 +1,40 @@
+#ifndef _P_IRQ_H
+#define _P_IRQ_H
+
+#include "peripherals/base.h"
+
+// BCM2835 interrupt controller
+#define IRQ_BASIC_PENDING   (PERIPHERAL_BASE+0x0000B200)
+#define IRQ_PENDING_1       (PERIPHERAL_BASE+0x0000B204)
+#define IRQ_PENDING_2       (PERIPHERAL_BASE+0x0000B208)
+#define FIQ_CONTROL         (PERIPHERAL_BASE+0x0000B20C)
+#define ENABLE_IRQS_1       (PERIPHERAL_BASE+0x0000B210)
+#define ENABLE_IRQS_2       (PERIPHERAL_BASE+0x0000B214)
+#define ENABLE_BASIC_IRQS   (PERIPHERAL_BASE+0x0000B218)
+#define DISABLE_IRQS_1      (PERIPHERAL_BASE+0x0000B21C)
+#define DISABLE_IRQS_2      (PERIPHERAL_BASE+0x0000B220)
+#define DISABLE_BASIC_IRQS  (PERIPHERAL_BASE+0x0000B224)
+
+// GPU IRQ 57 (PL011 UART0) lives in bank 2, DMA channels 0-12 are GPU
+// IRQs 16-28 in bank 1
+#define IRQ_2_UART0         (1 << 25)
+#define IRQ_1_DMA(n)        (1 << (16 + (n)))
+
+// BCM2836 per-core timer/mailbox routing and interrupt sources
+#define CORE_TIMER_IRQCNTL(n)   (LOCAL_PERIPHERAL_BASE+0x40+4*(n))
+#define CORE_MBOX_IRQCNTL(n)    (LOCAL_PERIPHERAL_BASE+0x50+4*(n))
+#define CORE_IRQ_SOURCE(n)      (LOCAL_PERIPHERAL_BASE+0x60+4*(n))
+#define LOCAL_TIMER_CNTV_IRQ    (1 << 3)
+#define LOCAL_MBOX0_IRQ         (1 << 0)
+
+#define LOCAL_IRQ_CNTV      (1 << 3)
+#define LOCAL_IRQ_MBOX0     (1 << 4)
+#define LOCAL_IRQ_GPU       (1 << 8)
+
+// Four mailboxes per core: write-set at 0x80, read/write-clear at 0xC0.
+// Mailbox 3 carries the secondary-core entry point (firmware and QEMU
+// spin on it), mailbox 0 is used for reschedule IPIs
+#define CORE_MBOX_SET(n, m)     (LOCAL_PERIPHERAL_BASE+0x80+0x10*(n)+4*(m))
+#define CORE_MBOX_CLR(n, m)     (LOCAL_PERIPHERAL_BASE+0xC0+0x10*(n)+4*(m))
+
+#endif  /*_P_IRQ_H */
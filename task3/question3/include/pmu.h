@@ -0,0 +1,55 @@
+#pragma once
+
+// Cortex-A7 PMU: cycle counter (PMCCNTR) and the four event counters,
+// usable once pmu_init() has run at EL1 on the core that reads them
+
+// Architectural event numbers; pmu_init programs counters 0-3 with PMU_EVENTS
+#define PMU_EV_L1D_REFILL       0x03
+#define PMU_EV_L1D_TLB_REFILL   0x05
+#define PMU_EV_INST_RETIRED     0x08
+#define PMU_EV_BR_MIS_PRED      0x10
+
+#define PMU_NR_EVENTS           4
+#define PMU_EVENTS              { PMU_EV_INST_RETIRED, PMU_EV_L1D_REFILL, \
+                                  PMU_EV_L1D_TLB_REFILL, PMU_EV_BR_MIS_PRED }
+
+// Counter number of each event in PMU_EVENTS, for pmu_event_read()
+#define PMU_CNT_INST_RETIRED    0
+#define PMU_CNT_L1D_REFILL      1
+#define PMU_CNT_L1D_TLB_REFILL  2
+#define PMU_CNT_BR_MIS_PRED     3
+
+static inline void pmu_event_select(unsigned int n, unsigned int event) {
+    asm volatile("mcr p15, 0, %0, c9, c12, 5" :: "r"(n));        // PMSELR
+    asm volatile("isb");
+    asm volatile("mcr p15, 0, %0, c9, c13, 1" :: "r"(event));    // PMXEVTYPER
+}
+
+static inline unsigned int pmu_event_read(unsigned int n) {
+    unsigned int count;
+    asm volatile("mcr p15, 0, %0, c9, c12, 5" :: "r"(n));        // PMSELR
+    asm volatile("isb");
+    asm volatile("mrc p15, 0, %0, c9, c13, 2" : "=r"(count));    // PMXEVCNTR
+    return count;
+}
+
+static inline void pmu_init(void) {
+    static const unsigned char events[PMU_NR_EVENTS] = PMU_EVENTS;
+    unsigned int pmcr;
+
+    for (unsigned int n = 0; n < PMU_NR_EVENTS; n++)
+        pmu_event_select(n, events[n]);
+
+    asm volatile("mrc p15, 0, %0, c9, c12, 0" : "=r"(pmcr));
+    pmcr |= (1 << 0) | (1 << 1) | (1 << 2); // E: enable, P: reset events, C: reset cycles
+    pmcr &= ~(1 << 3);              // D: count every cycle, not every 64th
+    asm volatile("mcr p15, 0, %0, c9, c12, 0" :: "r"(pmcr));
+    // PMCNTENSET: cycle counter and event counters 0-3
+    asm volatile("mcr p15, 0, %0, c9, c12, 1" :: "r"((1 << 31) | ((1 << PMU_NR_EVENTS) - 1)));
+}
+
+static inline unsigned int pmu_cycles(void) {
+    unsigned int cycles;
+    asm volatile("mrc p15, 0, %0, c9, c13, 0" : "=r"(cycles));
+    return cycles;
+}
@@ -1,4 +0,0 @@
-#pragma once
-
-void printf_init();
-void printf(const char *fmt, ...);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "barrier.h"
+
+/*
+ * Single-producer/single-consumer byte ring. The producer only advances
+ * head and the consumer only advances tail, so one side may run in IRQ
+ * context without a lock. The dmb orders the data access against the
+ * index update seen by the other side.
+ */
+#define RING_SIZE   1024    // Must be a power of two
+
+struct ring {
+    volatile unsigned int head;
+    volatile unsigned int tail;
+    unsigned char buf[RING_SIZE];
+};
+
+static inline unsigned int ring_count(const struct ring *r) {
+    return r->head - r->tail;
+}
+
+static inline unsigned int ring_space(const struct ring *r) {
+    return RING_SIZE - ring_count(r);
+}
+
+static inline int ring_put(struct ring *r, unsigned char c) {
+    unsigned int head = r->head;
+    if (head - r->tail == RING_SIZE)
+        return 0;
+    r->buf[head & (RING_SIZE - 1)] = c;
+    dmb();
+    r->head = head + 1;
+    return 1;
+}
+
+static inline int ring_get(struct ring *r, unsigned char *c) {
+    unsigned int tail = r->tail;
+    if (r->head == tail)
+        return 0;
+    dmb();
+    *c = r->buf[tail & (RING_SIZE - 1)];
+    dmb();
+    r->tail = tail + 1;
+    return 1;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "smp.h"
+#include "spinlock.h"
+#include "timer.h"
+
+#define NR_TASKS            128
+#define SCHED_SLICE_US      10000       // Default round-robin time slice
+
+#define TASK_UNUSED         0
+#define TASK_RUNNING        1           // Running or on a run queue
+#define TASK_IDLE           2           // A core's boot context once it idles
+#define TASK_ZOMBIE         3           // Exited or killed, waiting for task_kill
+#define TASK_SLEEPING       4           // On a wait queue, see sleep_on
+
+#ifndef __ASSEMBLER__
+
+// Kernel-side state saved by cpu_switch_to, which walks it in this order.
+// The interrupted user registers live in the trap frames on the task's
+// kernel stack; only the banked ones every task shares (sp_usr, lr_usr,
+// SPSR_svc) need a slot here
+struct cpu_context {
+    unsigned int r4, r5, r6, r7, r8, r9, r10, r11;
+    unsigned int sp;
+    unsigned int lr;
+    unsigned int spsr;
+    unsigned int sp_usr;
+    unsigned int lr_usr;
+};
+
+struct task {
+    struct cpu_context ctx;     // Must stay first
+    int pid;
+    volatile int state;
+    unsigned int kstack;        // Kernel stack page (0 for boot contexts)
+    struct task *next;          // Run queue link
+    unsigned int cpu;           // Run queue it is on, or last ran on
+    int queued;
+    int pinned;                 // Never stolen by another core
+    volatile int on_cpu;        // Its registers are live on some core
+    unsigned int *pgd;          // Own first-level table (0: kernel_ttb only)
+    unsigned int context_id;    // ASID generation | ASID, see asid.c
+    struct wait_queue *wq;      // Queue it sleeps on, if any
+    struct task *wq_next;
+    struct timer timer;         // Sleep timeout
+    const struct user_image *image;     // Program it runs (exec.h), or 0
+    unsigned long long exec_ticks;      // When it was exec'd
+    int exit_code;
+};
+
+// Tasks sleeping until an event (input, ...) wakes them all
+struct wait_queue {
+    spinlock_t lock;
+    struct task *head;
+};
+
+#define WAIT_QUEUE_INIT     { SPINLOCK_INIT, 0 }
+
+struct sched_stats {
+    unsigned int schedules;     // schedule() calls
+    unsigned int switches;      // ... that changed task
+    unsigned int steals;        // Tasks taken from another core's queue
+    unsigned int pick_cycles;   // Choosing the next task
+    unsigned int switch_cycles; // cpu_switch_to until the resumed task runs
+    unsigned int ticks;         // Slices that ran out
+    unsigned int wakeups;       // WFI exits while idle
+    unsigned long long idle_ticks;  // Generic timer ticks spent in WFI
+};
+
+extern struct task *cpu_curr[NR_CPUS];
+extern struct sched_stats sched_stats[NR_CPUS];
+
+#define current     (cpu_curr[smp_processor_id()])
+
+void sched_init(unsigned int slice_us);
+void sched_init_secondary(void);
+void sched_set_slice(unsigned int slice_us);
+void sched_set_active(unsigned int mask);
+struct svc_frame;
+struct user_image;
+
+int task_create(void (*entry)(void));
+int task_exec(const struct user_image *img);
+int task_exit_code(int pid);
+unsigned long long task_exec_ticks(int pid);
+int task_fork(struct svc_frame *f);
+void task_kill(int pid);
+int task_state(int pid);
+void schedule(void);
+void schedule_tail(void);
+void sched_ipi(void);
+void sched_preempt(void);
+void sched_idle(void);
+void sleep_on(struct wait_queue *wq, spinlock_t *lock);
+void sleep_on_timeout(struct wait_queue *wq, spinlock_t *lock, unsigned long long deadline);
+void sleep_us(unsigned int us);
+int wake_up(struct wait_queue *wq);
+
+void cpu_switch_to(struct cpu_context *prev, struct cpu_context *next);
+void ret_from_fork(void);
+void ret_from_fork_frame(void);
+
+#endif /* __ASSEMBLER__ */
@@ -0,0 +1,21 @@
+#pragma once
+
+#define NR_CPUS     4
+
+#ifndef __ASSEMBLER__
+
+// Core number from MPIDR.Aff0 (0-3 on the BCM2836)
+static inline unsigned int smp_processor_id(void) {
+    unsigned int mpidr;
+    asm volatile("mrc p15, 0, %0, c0, c0, 5" : "=r"(mpidr));
+    return mpidr & 3;
+}
+
+extern volatile unsigned int cpu_online_mask;
+
+void smp_init(void);
+void smp_send_reschedule(unsigned int cpu);
+void smp_handle_ipi(void);
+void secondary_main(unsigned int cpu);
+
+#endif /* __ASSEMBLER__ */
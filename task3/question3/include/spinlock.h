@@ -0,0 +1,106 @@
+#pragma once
+
+#include "irq.h"
+#include "barrier.h"
+
+/*
+ * Locks built on LDREX/STREX. They need the MMU and caches on (exclusives
+ * on Normal shareable memory go through the SCU's global monitor). Waiters
+ * sleep in WFE and unlock issues SEV, so spinning costs little power.
+ */
+
+typedef struct {
+    volatile unsigned int lock;
+} spinlock_t;
+
+#define SPINLOCK_INIT   { 0 }
+
+static inline void spin_lock(spinlock_t *l) {
+    unsigned int tmp;
+
+    asm volatile("1: ldrex %0, [%1]\n"
+                 "   teq %0, #0\n"
+                 "   wfene\n"
+                 "   strexeq %0, %2, [%1]\n"
+                 "   teqeq %0, #0\n"
+                 "   bne 1b"
+                 : "=&r"(tmp)
+                 : "r"(&l->lock), "r"(1)
+                 : "cc", "memory");
+    dmb();
+}
+
+static inline int spin_trylock(spinlock_t *l) {
+    unsigned int tmp;
+
+    asm volatile("ldrex %0, [%1]\n"
+                 "teq %0, #0\n"
+                 "strexeq %0, %2, [%1]"
+                 : "=&r"(tmp)
+                 : "r"(&l->lock), "r"(1)
+                 : "cc", "memory");
+    if (tmp)
+        return 0;
+    dmb();
+    return 1;
+}
+
+static inline void spin_unlock(spinlock_t *l) {
+    dmb();
+    l->lock = 0;
+    dsb();
+    asm volatile("sev");
+}
+
+static inline unsigned int spin_lock_irqsave(spinlock_t *l) {
+    unsigned int flags = irq_save();
+    spin_lock(l);
+    return flags;
+}
+
+static inline void spin_unlock_irqrestore(spinlock_t *l, unsigned int flags) {
+    spin_unlock(l);
+    irq_restore(flags);
+}
+
+/*
+ * Ticket lock: FIFO hand-off so a core that keeps re-taking a hot lock
+ * (the run queues under stealing) cannot starve the others. The next
+ * ticket lives in the top half-word and is taken with LDREX/STREX; only
+ * the holder writes the owner half-word, with a plain store.
+ */
+typedef struct {
+    union {
+        volatile unsigned int slock;
+        struct {
+            volatile unsigned short owner;
+            volatile unsigned short next;
+        } tickets;
+    };
+} ticket_lock_t;
+
+#define TICKET_LOCK_INIT    { { 0 } }
+
+static inline void ticket_lock(ticket_lock_t *l) {
+    unsigned int old, new, tmp;
+
+    asm volatile("1: ldrex %0, [%3]\n"
+                 "   add %1, %0, #0x10000\n"
+                 "   strex %2, %1, [%3]\n"
+                 "   teq %2, #0\n"
+                 "   bne 1b"
+                 : "=&r"(old), "=&r"(new), "=&r"(tmp)
+                 : "r"(&l->slock)
+                 : "cc", "memory");
+
+    while (l->tickets.owner != (unsigned short)(old >> 16))
+        asm volatile("wfe");
+    dmb();
+}
+
+static inline void ticket_unlock(ticket_lock_t *l) {
+    dmb();
+    l->tickets.owner++;
+    dsb();
+    asm volatile("sev");
+}
@@ -0,0 +1,175 @@
+#ifndef SYSCALL_H
+#define SYSCALL_H
+
+// Syscall numbers follow the Linux ARM EABI numbering where one exists;
+// SYS_NULL does nothing and exists to time the trap path
+#define SYS_NULL        0
+#define SYS_EXIT        1
+#define SYS_FORK        2
+#define SYS_READ        3
+#define SYS_WRITE       4
+#define SYS_EXECVE      11      // Path only: no argv or envp
+#define SYS_GETPID      20
+#define SYS_WRITEV      146
+#define SYS_SCHED_YIELD 158
+#define SYS_TRACE_CTL   159     // Not Linux: tracing control, TRACE=1 builds only
+#define SYS_CHAN_CREATE 160     // Not Linux: IPC channels, see ipc.h
+#define SYS_CHAN_MAP    161
+#define SYS_CHAN_SEND   162
+#define SYS_CHAN_RECV   163
+#define SYS_POLL        168
+#define SYS_FUTEX       240
+#define NR_SYSCALLS     241
+
+// syscall_table flags: handler needs the full trap frame (r0-r12, lr)
+#define SYSCALL_FULL_SAVE   1
+
+// Negative return values, as in Linux
+#define ENOENT          2
+#define EBADF           9
+#define EAGAIN          11
+#define ENOMEM          12
+#define EFAULT          14
+#define EINVAL          22
+#define ENOSYS          38
+
+#define STDIN_FILENO    0
+#define STDOUT_FILENO   1
+#define STDERR_FILENO   2
+
+#define IOV_MAX         16
+#define POLL_MAX        16
+
+// struct pollfd events/revents
+#define POLLIN          0x0001
+#define POLLOUT         0x0004
+#define POLLNVAL        0x0020
+
+// futex() operations
+#define FUTEX_WAIT      0
+#define FUTEX_WAKE      1
+
+#ifndef __ASSEMBLER__
+
+struct iovec {
+    const void *iov_base;
+    unsigned int iov_len;
+};
+
+struct pollfd {
+    int fd;
+    short events;
+    short revents;
+};
+
+// Registers saved by the full-save path of svc_handler, lowest address first
+struct svc_frame {
+    unsigned int r[13];
+    unsigned int lr;
+};
+
+// Fast handlers get (r0, r1, r2); full-save handlers also get the frame
+typedef int (*syscall_fn)(unsigned int, unsigned int, unsigned int, struct svc_frame *);
+
+struct syscall_entry {
+    syscall_fn fn;
+    unsigned int flags;
+};
+
+/*
+ * EL0 wrappers, Linux EABI style: number in r7, arguments in r0-r2 and
+ * the result back in r0. lr is listed as clobbered so the same wrappers
+ * can be issued from SVC mode (the benchmarks do), where the trap
+ * overwrites lr_svc. They are always inlined so that code placed in the
+ * user image (__user_text) does not call back into kernel-only text, even
+ * at -O0.
+ */
+#define __syscall_inline    static inline __attribute__((always_inline))
+
+__syscall_inline int syscall3(int nr, unsigned int a0, unsigned int a1, unsigned int a2) {
+    register unsigned int r0 asm("r0") = a0;
+    register unsigned int r1 asm("r1") = a1;
+    register unsigned int r2 asm("r2") = a2;
+    register int r7 asm("r7") = nr;
+    asm volatile("svc #0"
+                 : "+r"(r0)
+                 : "r"(r1), "r"(r2), "r"(r7)
+                 : "lr", "memory");
+    return r0;
+}
+
+// Blocks until input is there; on the console in cooked mode, one line
+__syscall_inline int read(int fd, void *buf, unsigned int len) {
+    return syscall3(SYS_READ, fd, (unsigned int)buf, len);
+}
+
+// timeout in ms: 0 only checks, negative waits for as long as it takes
+__syscall_inline int poll(struct pollfd *fds, unsigned int nfds, int timeout) {
+    return syscall3(SYS_POLL, (unsigned int)fds, nfds, timeout);
+}
+
+__syscall_inline int write(int fd, const void *buf, unsigned int len) {
+    return syscall3(SYS_WRITE, fd, (unsigned int)buf, len);
+}
+
+__syscall_inline int writev(int fd, const struct iovec *iov, int iovcnt) {
+    return syscall3(SYS_WRITEV, fd, (unsigned int)iov, iovcnt);
+}
+
+__syscall_inline int getpid(void) {
+    return syscall3(SYS_GETPID, 0, 0, 0);
+}
+
+__syscall_inline void exit(int status) {
+    syscall3(SYS_EXIT, status, 0, 0);
+}
+
+// Only returns on failure
+__syscall_inline int execve(const char *path) {
+    return syscall3(SYS_EXECVE, (unsigned int)path, 0, 0);
+}
+
+// Returns the child's pid in the parent and 0 in the child
+__syscall_inline int fork(void) {
+    return syscall3(SYS_FORK, 0, 0, 0);
+}
+
+__syscall_inline int sched_yield(void) {
+    return syscall3(SYS_SCHED_YIELD, 0, 0, 0);
+}
+
+// FUTEX_WAIT sleeps while *uaddr == val; FUTEX_WAKE wakes the sleepers
+// on uaddr and returns how many there were. Keyed by physical address, so
+// it works across processes on a shared page
+__syscall_inline int futex(volatile unsigned int *uaddr, int op, unsigned int val) {
+    return syscall3(SYS_FUTEX, (unsigned int)uaddr, op, val);
+}
+
+// A new channel's id; any process may chan_map it
+__syscall_inline int chan_create(void) {
+    return syscall3(SYS_CHAN_CREATE, 0, 0, 0);
+}
+
+// Map channel id's ring into the caller and return its address
+__syscall_inline int chan_map(int id) {
+    return syscall3(SYS_CHAN_MAP, id, 0, 0);
+}
+
+// The copying path: one message through a kernel-side ring of the
+// channel, blocking while it is full or empty
+__syscall_inline int chan_send(int id, const void *buf, unsigned int len) {
+    return syscall3(SYS_CHAN_SEND, id, (unsigned int)buf, len);
+}
+
+__syscall_inline int chan_recv(int id, void *buf, unsigned int len) {
+    return syscall3(SYS_CHAN_RECV, id, (unsigned int)buf, len);
+}
+
+// cmd is one of the TRACE_CTL_* values in trace.h
+__syscall_inline int trace_ctl(unsigned int cmd, unsigned int arg) {
+    return syscall3(SYS_TRACE_CTL, cmd, arg, 0);
+}
+
+#endif /* __ASSEMBLER__ */
+
+#endif
@@ -0,0 +1,60 @@
+#pragma once
+
+// ARMv7 generic timer: free-running physical count and its frequency
+
+static inline unsigned long long timer_count(void) {
+    unsigned long long count;
+    asm volatile("isb\n"
+                 "mrrc p15, 0, %Q0, %R0, c14" : "=r"(count));
+    return count;
+}
+
+static inline unsigned int timer_freq(void) {
+    unsigned int freq;
+    asm volatile("mrc p15, 0, %0, c14, c0, 0" : "=r"(freq));
+    return freq;
+}
+
+// Virtual timer (CNTV): one-shot countdown that raises the per-core CNTV
+// interrupt, which the BCM2836 local controller routes as CNTVIRQ
+#define CNTV_CTL_ENABLE     (1 << 0)
+#define CNTV_CTL_IMASK      (1 << 1)
+
+static inline void timer_arm(unsigned int ticks) {
+    asm volatile("mcr p15, 0, %0, c14, c3, 0" :: "r"(ticks));             // CNTV_TVAL
+    asm volatile("mcr p15, 0, %0, c14, c3, 1" :: "r"(CNTV_CTL_ENABLE));   // CNTV_CTL
+    asm volatile("isb");
+}
+
+static inline void timer_disarm(void) {
+    asm volatile("mcr p15, 0, %0, c14, c3, 1" :: "r"(0));
+    asm volatile("isb");
+}
+
+/*
+ * One-shot software timers, kept per core in deadline order. The core's
+ * CNTV is programmed for the earliest one only, so a core with nothing
+ * pending takes no timer interrupts at all. A timer fires on the core that
+ * added it; fn runs in IRQ context.
+ */
+struct timer {
+    unsigned long long expires;     // timer_count() value
+    void (*fn)(struct timer *t);
+    struct timer *next;
+    int cpu;                        // Base it is pending on, -1 if none
+};
+
+#define TIMER_INIT(f)   { 0, (f), 0, -1 }
+
+// Waits up to this long spin on the counter instead of sleeping
+#define UDELAY_MAX_US   10
+
+void timer_init(void);
+unsigned int timer_us_to_ticks(unsigned int us);
+void timer_add(struct timer *t);
+void timer_del(struct timer *t);
+void timer_del_sync(struct timer *t);
+void timer_handle_irq(void);
+void udelay(unsigned int us);
+
+extern unsigned int timer_irqs[];
@@ -0,0 +1,76 @@
+#pragma once
+
+/*
+ * Event tracing, built only with `make TRACE=1`. Each core appends
+ * timestamped records to its own ring with IRQs masked, so recording takes
+ * no lock and never prints. trace_dump() sends the rings over the UART in
+ * the binary layout below; tools/trace_decode.py turns that into
+ * Chrome-trace JSON and latency histograms. The oldest records are
+ * overwritten once a ring is full.
+ */
+
+// Record types
+#define TRACE_SYSCALL_ENTER     1       // arg: syscall number
+#define TRACE_SYSCALL_EXIT      2       // arg: syscall number
+#define TRACE_IRQ_ENTER         3       // arg: CORE_IRQ_SOURCE bits
+#define TRACE_IRQ_EXIT          4
+#define TRACE_SWITCH            5       // arg: pid switched to
+#define TRACE_FAULT             6       // arg: faulting address
+#define TRACE_MARK              7       // arg: caller-defined
+
+#define TRACE_RING_SHIFT        10      // 1024 records (16 KB) per core
+#define TRACE_RING_SIZE         (1 << TRACE_RING_SHIFT)
+
+// Dump framing: header, then per core a trace_cpu_header and its records
+// oldest first, then TRACE_MAGIC_END. All fields little-endian.
+#define TRACE_MAGIC             0x43525449      // "ITRC"
+#define TRACE_MAGIC_END         0x45525449      // "ITRE"
+#define TRACE_VERSION           1
+
+// trace_ctl() commands
+#define TRACE_CTL_STOP          0
+#define TRACE_CTL_START         1       // Clears the rings first
+#define TRACE_CTL_DUMP          2       // Stops, then dumps
+#define TRACE_CTL_MARK          3       // Records TRACE_MARK with the given arg
+
+#ifndef __ASSEMBLER__
+
+#include "pmu.h"
+
+struct trace_event {
+    unsigned int cycles;        // PMCCNTR of the recording core
+    unsigned int ts;            // Low word of the generic timer, shared by all cores
+    unsigned int arg;
+    unsigned char type;
+    unsigned char cpu;
+    unsigned short pid;         // Task running when the record was taken
+};
+
+struct trace_header {
+    unsigned int magic;
+    unsigned short version;
+    unsigned short ncpus;
+    unsigned int timer_hz;
+    unsigned short event_size;
+    unsigned char pmu_events[PMU_NR_EVENTS];
+    unsigned short reserved;
+};
+
+struct trace_cpu_header {
+    unsigned int cpu;
+    unsigned int count;         // Records that follow
+    unsigned int lost;          // Older records overwritten
+    unsigned int pmu[PMU_NR_EVENTS];    // Event counters at the dump (dumping core)
+                                        // or at the core's last TRACE_SWITCH
+};
+
+#ifdef TRACE
+void trace_event(unsigned int type, unsigned int arg);
+void trace_start(void);
+void trace_stop(void);
+void trace_dump(void);
+#else
+static inline void trace_event(unsigned int type, unsigned int arg) {}
+#endif
+
+#endif /* __ASSEMBLER__ */
@@ -1,6 +1,80 @@
 #pragma once
 
-#define TRANSLATION_TABLE_BASE 0x4000
+// The first-level table is built at compile time (translation.c) and
+// linked into .pgtable; TTBR0 needs it 16 KB aligned
+#define L1_TABLE_ALIGN            0x4000
+#define L1_TABLE_ORDER            2         // 4 frames, for alloc_pages()
 
-void map_kernel_and_user_space();
+// First-level section descriptor fields (short-descriptor format, SCTLR.TRE = 0)
+#define SECTION_DESCRIPTOR        0x2
+#define SECTION_ADDR_MASK         0xFFF00000
+#define SECTION_B                 (1 << 2)
+#define SECTION_C                 (1 << 3)
+#define SECTION_XN                (1 << 4)
+#define SECTION_TEX(x)            ((x) << 12)
+#define SECTION_S                 (1 << 16)
+
+// Supersection: a section descriptor with bit 18 set that maps 16 MB and
+// must be repeated in all 16 first-level entries it covers
+#define SUPERSECTION              (1 << 18)
+#define SUPERSECTION_ADDR_MASK    0xFF000000
+#define SUPERSECTION_ENTRIES      16
+
+// Memory types: write-back write-allocate shareable RAM, shareable device MMIO
+#define REGION_NORMAL             (SECTION_TEX(1) | SECTION_C | SECTION_B | SECTION_S)
+#define REGION_DEVICE             (SECTION_B | SECTION_XN)
+#define REGION_STRONGLY_ORDERED   0x00000000
+
+// First-level coarse descriptor pointing at a 256-entry second-level table
+#define COARSE_DESCRIPTOR         0x1
+#define COARSE_ADDR_MASK          0xFFFFFC00
+#define L2_ENTRIES                256
+#define L2_TABLE_SIZE             (L2_ENTRIES * 4)
+
+// Second-level small (4 KB) page descriptor fields
+#define SMALL_PAGE                0x2
+#define PAGE_XN                   (1 << 0)
+#define PAGE_B                    (1 << 2)
+#define PAGE_C                    (1 << 3)
+#define PAGE_AP(x)                ((x) << 4)
+#define PAGE_TEX(x)               ((x) << 6)
+#define PAGE_S                    (1 << 10)
+#define PAGE_NG                   (1 << 11)  // Not global: tagged with the ASID
+#define PAGE_NORMAL               (PAGE_TEX(1) | PAGE_C | PAGE_B | PAGE_S)
+
+// Second-level large (64 KB) page: repeated in the 16 entries it covers;
+// XN and TEX move, the other fields are where a small page has them
+#define LARGE_PAGE                0x1
+#define LARGE_PAGE_SIZE           0x10000
+#define LARGE_PAGE_ENTRIES        16
+#define LARGE_PAGE_XN             (1 << 15)
+#define LARGE_PAGE_TEX(x)         ((x) << 12)
+#define LARGE_PAGE_NORMAL         (LARGE_PAGE_TEX(1) | PAGE_C | PAGE_B | PAGE_S)
+
+#define AP_NO_ACCESS              0x00
+#define AP_PRIV_RW_USER_NO        0x01
+#define AP_PRIV_RW_USER_RO        0x02
+#define AP_PRIV_RW_USER_RW        0x03
+
+// Table walks are inner/outer write-back write-allocate and shareable, so
+// table updates made through the cached mapping are seen by the walker
+#define TTBR_WALK_ATTRS           ((1 << 6) | (1 << 3) | (1 << 1))
+
+#ifndef __ASSEMBLER__
+
+extern unsigned int kernel_ttb[];
+
+void map_user_image(void);
+unsigned int *pgd_alloc(void);
+void pgd_free(unsigned int *pgd);
+void pgd_clear(unsigned int *pgd);
+int pgd_copy_cow(unsigned int *dst, unsigned int *src);
 unsigned int *get_translation_table();
+int user_range_ok(unsigned int addr, unsigned int len, int write);
+int map_page(unsigned int *l1, unsigned int va, unsigned int pa, unsigned int attrs);
+unsigned int unmap_page(unsigned int *l1, unsigned int va);
+unsigned int *lookup_pte(unsigned int *l1, unsigned int va);
+void split_supersection(unsigned int *l1, unsigned int va);
+int merge_supersection(unsigned int *l1, unsigned int va);
+
+#endif /* __ASSEMBLER__ */
@@ -1,5 +1,11 @@
 #ifndef USER_H
 #define USER_H
 
-void user_mode_entry();
+// Place kernel-built objects in the user image (linker.ld .user) so EL0
+// may run or read them, e.g. buffers the benchmarks pass to syscalls.
+// Standalone programs live in user/ and are loaded from the initramfs.
+#define __user_text     __attribute__((section(".user.text")))
+#define __user_rodata   __attribute__((section(".user.rodata")))
+#define __user_data     __attribute__((section(".user.data")))
+
 #endif
@@ -1,5 +1,5 @@
 #pragma once
 
-void delay(unsigned int count);
 void put32(unsigned int addr, unsigned int value);
 unsigned int get32(unsigned int addr);
+unsigned long long udiv64(unsigned long long n, unsigned int d);
@@ -0,0 +1,61 @@
+#include "arena.h"
+#include "kmalloc.h"
+#include "mm.h"
+
+// Chunk bookkeeping lives in kmalloc, so the chunk itself stays whole and
+// a request of exactly 2^n pages needs no more than that
+struct arena_chunk {
+    struct arena_chunk *next;
+    unsigned int base;
+    unsigned int order;
+};
+
+// Start a chunk of at least size bytes; it replaces the current one, whose
+// unused tail is given up
+static int arena_grow(struct arena *a, unsigned int size) {
+    struct arena_chunk *c = kmalloc(sizeof(*c));
+    unsigned int order = ARENA_CHUNK_ORDER;
+
+    if (!c)
+        return -1;
+    while (((unsigned int)PAGE_SIZE << order) < size)
+        order++;
+    c->base = alloc_pages(order);
+    if (!c->base) {
+        kfree(c);
+        return -1;
+    }
+    c->order = order;
+    c->next = a->chunks;
+    a->chunks = c;
+    a->cur = c->base;
+    a->end = c->base + (PAGE_SIZE << order);
+    return 0;
+}
+
+// Zeroed memory aligned to align (a power of two up to the chunk size), or
+// 0 when out of memory. Chunks are size-aligned, so fresh ones need no
+// padding.
+void *arena_alloc(struct arena *a, unsigned int size, unsigned int align) {
+    unsigned int p = (a->cur + align - 1) & ~(align - 1);
+
+    if (!a->chunks || p + size > a->end || p + size < p) {
+        if (arena_grow(a, size) < 0)
+            return 0;
+        p = a->cur;
+    }
+    a->cur = p + size;
+    a->bytes += size;
+    return (void *)p;
+}
+
+void arena_release(struct arena *a) {
+    while (a->chunks) {
+        struct arena_chunk *c = a->chunks;
+        a->chunks = c->next;
+        free_pages(c->base, c->order);
+        kfree(c);
+    }
+    a->cur = a->end = 0;
+    a->bytes = 0;
+}
@@ -0,0 +1,119 @@
+#include "asid.h"
+#include "sched.h"
+#include "smp.h"
+#include "spinlock.h"
+#include "barrier.h"
+#include "translation.h"
+
+// Generation in the bits above the ASID; starts at 1 so that a zeroed
+// context_id never matches
+static volatile unsigned int asid_generation = NR_ASIDS;
+static unsigned int asid_map[NR_ASIDS / 32];
+static unsigned int asid_next = 1;
+static spinlock_t asid_lock = SPINLOCK_INIT;
+
+// Set by a rollover: the core must flush its TLB before the next process
+// runs, since ASIDs of the old generation are about to be reused
+static volatile unsigned int flush_pending[NR_CPUS];
+
+// Cleared by the benchmarks: every process then runs as ASID 0 and each
+// switch flushes the TLB, as without ASIDs
+static volatile int asid_enabled = 1;
+
+struct asid_stats asid_stats;
+
+static unsigned int find_free_asid(void) {
+    for (unsigned int n = 0; n < NR_ASIDS; n++) {
+        unsigned int asid = (asid_next + n) & ASID_MASK;
+        if (asid && !(asid_map[asid / 32] & (1u << (asid % 32)))) {
+            asid_next = asid + 1;
+            return asid;
+        }
+    }
+    return 0;
+}
+
+// Give t an ASID of the current generation, rolling over when none is left.
+// ASIDs are never freed individually, so a dead process's stale TLB
+// entries stay harmless until the flush that comes with the rollover.
+static unsigned int new_context(struct task *t) {
+    unsigned int asid;
+
+    spin_lock(&asid_lock);
+    if ((t->context_id ^ asid_generation) >> ASID_BITS) {
+        asid = find_free_asid();
+        if (!asid) {
+            asid_generation += NR_ASIDS;
+            for (unsigned int i = 0; i < NR_ASIDS / 32; i++)
+                asid_map[i] = 0;
+            for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++)
+                flush_pending[cpu] = 1;
+            asid_stats.rollovers++;
+            asid = find_free_asid();
+        }
+        asid_map[asid / 32] |= 1u << (asid % 32);
+        asid_stats.allocs++;
+        t->context_id = asid_generation | asid;
+    }
+    spin_unlock(&asid_lock);
+    return t->context_id;
+}
+
+// Install next's address space on this core; called by schedule() with
+// IRQs masked, from kernel text that every table maps globally. The
+// reserved ASID 0 is current while TTBR0 changes, so no walk can pair the
+// new table with the old ASID or the other way round.
+void switch_mm(struct task *next) {
+    unsigned int cpu = smp_processor_id();
+    unsigned int *pgd = next->pgd ? next->pgd : kernel_ttb;
+    unsigned int asid = 0;
+    int flush = 0;
+
+    if (next->pgd) {
+        if (asid_enabled) {
+            unsigned int ctx = next->context_id;
+            if ((ctx ^ asid_generation) >> ASID_BITS)
+                ctx = new_context(next);
+            asid = ctx & ASID_MASK;
+        } else {
+            flush = 1;
+        }
+    }
+    if (flush_pending[cpu]) {
+        flush_pending[cpu] = 0;
+        flush = 1;
+    }
+
+    asid_stats.flushes += flush;
+    asm volatile("mcr p15, 0, %0, c13, c0, 1" :: "r"(0));              // CONTEXTIDR
+    isb();
+    asm volatile("mcr p15, 0, %0, c2, c0, 0" :: "r"((unsigned int)pgd | TTBR_WALK_ATTRS));
+    isb();
+    if (flush) {
+        asm volatile("mcr p15, 0, %0, c8, c7, 0" :: "r"(0));           // TLBIALL, this core
+        dsb();
+        isb();
+    }
+    asm volatile("mcr p15, 0, %0, c13, c0, 1" :: "r"(asid));
+    isb();
+}
+
+// Drop the current process's non-global TLB entries on every core, after
+// its tables lost permissions (fork). With ASIDs off that is ASID 0.
+void flush_tlb_asid(void) {
+    unsigned int asid;
+
+    asm volatile("mrc p15, 0, %0, c13, c0, 1" : "=r"(asid));
+    dsb();
+    asm volatile("mcr p15, 0, %0, c8, c3, 2" :: "r"(asid & ASID_MASK));    // TLBIASIDIS
+    dsb();
+    isb();
+}
+
+// Switching modes leaves ASID-0 entries of processes behind, so every core
+// flushes before it next runs one
+void asid_set_enabled(int enabled) {
+    asid_enabled = enabled;
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++)
+        flush_pending[cpu] = 1;
+}
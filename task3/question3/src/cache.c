@@ -0,0 +1,98 @@
+#include "cache.h"
+#include "barrier.h"
+
+// Set/way maintenance and cache_disable live in cache.S
+
+// SCTLR bits
+#define SCTLR_C     (1 << 2)    // D-cache and unified caches
+#define SCTLR_Z     (1 << 11)   // Branch prediction
+#define SCTLR_I     (1 << 12)   // I-cache
+
+// ACTLR.SMP: Cortex-A7 needs it set before D-cache data can be cached
+#define ACTLR_SMP   (1 << 6)
+
+static unsigned int read_sctlr(void) {
+    unsigned int sctlr;
+    asm volatile("mrc p15, 0, %0, c1, c0, 0" : "=r"(sctlr));
+    return sctlr;
+}
+
+static void write_sctlr(unsigned int sctlr) {
+    asm volatile("mcr p15, 0, %0, c1, c0, 0" :: "r"(sctlr) : "memory");
+    isb();
+}
+
+// Smallest D-cache line in bytes, from CTR.DminLine (log2 of words)
+static unsigned int dcache_line_size(void) {
+    unsigned int ctr;
+    asm volatile("mrc p15, 0, %0, c0, c0, 1" : "=r"(ctr));
+    return 4 << ((ctr >> 16) & 0xF);
+}
+
+void icache_invalidate_all(void) {
+    asm volatile("mcr p15, 0, %0, c7, c5, 0" :: "r"(0));   // ICIALLU
+    asm volatile("mcr p15, 0, %0, c7, c5, 6" :: "r"(0));   // BPIALL
+    dsb();
+    isb();
+}
+
+void dcache_clean_range(unsigned int start, unsigned int len) {
+    unsigned int line = dcache_line_size();
+    unsigned int end = start + len;
+
+    for (unsigned int addr = start & ~(line - 1); addr < end; addr += line)
+        asm volatile("mcr p15, 0, %0, c7, c10, 1" :: "r"(addr));   // DCCMVAC
+    dsb();
+}
+
+// Partial lines at either end also hold data outside the range, so they are
+// cleaned and invalidated rather than thrown away
+void dcache_invalidate_range(unsigned int start, unsigned int len) {
+    unsigned int line = dcache_line_size();
+    unsigned int end = start + len;
+    unsigned int addr = start & ~(line - 1);
+
+    if (start & (line - 1)) {
+        asm volatile("mcr p15, 0, %0, c7, c14, 1" :: "r"(addr));  // DCCIMVAC
+        addr += line;
+    }
+    if ((end & (line - 1)) && addr < end) {
+        asm volatile("mcr p15, 0, %0, c7, c14, 1" :: "r"(end & ~(line - 1)));
+        end &= ~(line - 1);
+    }
+    for (; addr < end; addr += line)
+        asm volatile("mcr p15, 0, %0, c7, c6, 1" :: "r"(addr));   // DCIMVAC
+    dsb();
+}
+
+void dcache_clean_invalidate_range(unsigned int start, unsigned int len) {
+    unsigned int line = dcache_line_size();
+    unsigned int end = start + len;
+
+    for (unsigned int addr = start & ~(line - 1); addr < end; addr += line)
+        asm volatile("mcr p15, 0, %0, c7, c14, 1" :: "r"(addr));  // DCCIMVAC
+    dsb();
+}
+
+int cache_enabled(void) {
+    return (read_sctlr() & SCTLR_C) != 0;
+}
+
+void cache_enable(void) {
+    write_sctlr(read_sctlr() | SCTLR_C | SCTLR_I | SCTLR_Z);
+}
+
+// Bring-up after reset: caches may hold garbage, so invalidate everything
+// before the first enable. Called with the MMU on (mmu_init).
+void cache_init(void) {
+    unsigned int actlr;
+
+    asm volatile("mrc p15, 0, %0, c1, c0, 1" : "=r"(actlr));
+    actlr |= ACTLR_SMP;
+    asm volatile("mcr p15, 0, %0, c1, c0, 1" :: "r"(actlr));
+    isb();
+
+    dcache_invalidate_all();
+    icache_invalidate_all();
+    cache_enable();
+}
@@ -0,0 +1,42 @@
+#include "dma.h"
+#include "utils.h"
+#include "barrier.h"
+#include "peripherals/dma.h"
+#include "peripherals/irq.h"
+
+// Bus address of kernel memory; the kernel runs identity-mapped
+unsigned int dma_bus_addr(const void *p) {
+    return (unsigned int)p | BUS_RAM_UNCACHED;
+}
+
+unsigned int dma_bus_periph(unsigned int addr) {
+    return addr - PERIPHERAL_BASE + BUS_PERIPHERAL_BASE;
+}
+
+// Reset the channel, enable it and route its completion IRQ (GPU IRQ
+// 16 + ch, bank 1) to the controller
+void dma_channel_init(unsigned int ch) {
+    put32(DMA_ENABLE, get32(DMA_ENABLE) | (1 << ch));
+    put32(DMA_CS(ch), DMA_CS_RESET);
+    while (get32(DMA_CS(ch)) & DMA_CS_RESET);
+    put32(DMA_CS(ch), DMA_CS_END | DMA_CS_INT);
+    put32(ENABLE_IRQS_1, IRQ_1_DMA(ch));
+}
+
+// Run the chain starting at cb. The blocks and the data they point at must
+// already be cleaned to the point of coherency.
+void dma_start(unsigned int ch, const struct dma_cb *cb) {
+    dsb();
+    put32(DMA_CONBLK_AD(ch), dma_bus_addr(cb));
+    put32(DMA_CS(ch), DMA_CS_ACTIVE | DMA_CS_WAIT_WRITES |
+                      DMA_CS_PRIORITY(1) | DMA_CS_PANIC_PRIORITY(15));
+}
+
+// The chain has run to its end (or stopped on an error)
+int dma_done(unsigned int ch) {
+    return !(get32(DMA_CS(ch)) & DMA_CS_ACTIVE);
+}
+
+void dma_ack(unsigned int ch) {
+    put32(DMA_CS(ch), DMA_CS_END | DMA_CS_INT);
+}
@@ -0,0 +1,151 @@
+#include "exec.h"
+#include "elf.h"
+#include "mm.h"
+#include "sched.h"
+#include "syscall.h"
+#include "translation.h"
+#include "asid.h"
+#include "printf.h"
+#include "string.h"
+#include "spinlock.h"
+#include "kmalloc.h"
+
+#define PSR_MODE_USR    0x10
+
+// The archive, embedded by src/initramfs.S
+extern char initramfs_start[], initramfs_end[];
+
+static const struct initramfs_header *archive;
+static struct user_image *images[INITRAMFS_MAX];    // Parsed on first use
+static spinlock_t images_lock = SPINLOCK_INIT;
+
+/*
+ * Check the archive and take one reference on each of its frames. They
+ * sit below the allocator's range, and that reference keeps the last
+ * instance of a program from handing its text pages to page_put's free.
+ */
+void initramfs_init(void) {
+    const struct initramfs_header *h = (const struct initramfs_header *)initramfs_start;
+    unsigned int size = initramfs_end - initramfs_start;
+
+    if (size < sizeof(*h) || h->magic != INITRAMFS_MAGIC || h->count > INITRAMFS_MAX) {
+        printf("initramfs: no archive\n");
+        return;
+    }
+    for (unsigned int pa = (unsigned int)initramfs_start; pa < (unsigned int)initramfs_end; pa += PAGE_SIZE)
+        page_get(pa);
+    archive = h;
+    printf("initramfs: %u programs, %u KB\n", h->count, size / 1024);
+}
+
+static int streq(const char *a, const char *b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+/*
+ * Turn the PT_LOAD headers into segments. Every segment must sit in the
+ * image window with its file offset congruent to its address modulo the
+ * page size (user/user.ld links with 4 KB max-page-size), so a file page
+ * can back a user page directly.
+ */
+static struct user_image *image_parse(const struct initramfs_entry *e) {
+    unsigned int base = (unsigned int)archive + e->offset;
+    const struct elf32_ehdr *eh = (const struct elf32_ehdr *)base;
+    const struct elf32_phdr *ph;
+    struct user_image *img;
+
+    if (e->size < sizeof(*eh) || *(const unsigned int *)eh->e_ident != ELFMAG ||
+        eh->e_ident[4] != ELFCLASS32 || eh->e_ident[5] != ELFDATA2LSB ||
+        eh->e_type != ET_EXEC || eh->e_machine != EM_ARM ||
+        eh->e_phentsize != sizeof(*ph) || eh->e_phoff + eh->e_phnum * sizeof(*ph) > e->size)
+        return 0;
+
+    img = kzalloc(sizeof(*img));
+    if (!img)
+        return 0;
+    img->name = e->name;
+    img->entry = eh->e_entry;
+
+    ph = (const struct elf32_phdr *)(base + eh->e_phoff);
+    for (unsigned int i = 0; i < eh->e_phnum; i++, ph++) {
+        struct user_segment *s = &img->segs[img->nsegs];
+
+        if (ph->p_type != PT_LOAD || !ph->p_memsz)
+            continue;
+        if (img->nsegs == USER_IMAGE_SEGS || ph->p_filesz > ph->p_memsz ||
+            ph->p_offset + ph->p_filesz > e->size ||
+            (ph->p_offset & (PAGE_SIZE - 1)) != (ph->p_vaddr & (PAGE_SIZE - 1)) ||
+            ph->p_vaddr < USER_IMAGE_BASE ||
+            ph->p_vaddr + ph->p_memsz > USER_IMAGE_BASE + USER_IMAGE_SIZE) {
+            kfree(img);
+            return 0;
+        }
+        s->start = ph->p_vaddr & ~(PAGE_SIZE - 1);
+        s->end = PAGE_ALIGN(ph->p_vaddr + ph->p_memsz);
+        s->vaddr = ph->p_vaddr;
+        s->file = base + ph->p_offset;
+        s->filesz = ph->p_filesz;
+        s->memsz = ph->p_memsz;
+        s->flags = ph->p_flags;
+        if (!(s->flags & PF_W))
+            img->text_pages += (s->end - s->start) / PAGE_SIZE;
+        img->nsegs++;
+    }
+    if (!img->nsegs || !image_segment(img, img->entry)) {
+        kfree(img);
+        return 0;
+    }
+    return img;
+}
+
+// The parsed program called name, or 0 if the archive has no valid one
+const struct user_image *image_lookup(const char *name) {
+    const struct initramfs_entry *e;
+    struct user_image *img = 0;
+    unsigned int flags;
+
+    if (!archive)
+        return 0;
+    e = (const struct initramfs_entry *)(archive + 1);
+    for (unsigned int i = 0; i < archive->count; i++, e++) {
+        if (!streq(e->name, name))
+            continue;
+        flags = spin_lock_irqsave(&images_lock);
+        if (!images[i])
+            images[i] = image_parse(e);
+        img = images[i];
+        spin_unlock_irqrestore(&images_lock, flags);
+        break;
+    }
+    return img;
+}
+
+const struct user_segment *image_segment(const struct user_image *img, unsigned int va) {
+    for (unsigned int i = 0; i < img->nsegs; i++)
+        if (va >= img->segs[i].start && va < img->segs[i].end)
+            return &img->segs[i];
+    return 0;
+}
+
+/*
+ * execve: drop the caller's mappings and make its syscall return enter
+ * img at its entry point, with empty registers and a fresh stack. Nothing
+ * of the program is mapped yet; its first instruction fetch faults.
+ */
+void exec_image(struct svc_frame *f, const struct user_image *img) {
+    unsigned int user_regs[2] = { USER_STACK_TOP, 0 };     // sp_usr, lr_usr
+
+    pgd_clear(current->pgd);
+    flush_tlb_asid();
+    current->image = img;
+
+    memzero((unsigned long)f, sizeof(*f));
+    f->lr = img->entry;
+    asm volatile("msr spsr_cxsf, %0" :: "r"(PSR_MODE_USR));
+    asm volatile("ldmia %0, {sp, lr}^\n"
+                 "nop" :: "r"(user_regs) : "memory");
+}
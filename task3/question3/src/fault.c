@@ -0,0 +1,199 @@
+#include "fault.h"
+#include "mm.h"
+#include "sched.h"
+#include "translation.h"
+#include "printf.h"
+#include "string.h"
+#include "pmu.h"
+#include "trace.h"
+#include "exec.h"
+#include "elf.h"
+#include "cache.h"
+
+#define PSR_MODE_MASK   0x1F
+#define PSR_MODE_USR    0x10
+
+// Private pages: cacheable, never executable, tagged with the ASID
+#define USER_PAGE_ATTRS (PAGE_NORMAL | PAGE_XN | PAGE_NG)
+
+struct fault_stats fault_stats[NR_CPUS];
+
+// Windows every process owns a private copy of; nothing else is paged
+static int in_demand_area(unsigned int va) {
+    return (va >= USER_STACK_TOP - USER_STACK_SIZE && va < USER_STACK_TOP) ||
+           (va >= USER_HEAP_BASE && va < USER_HEAP_BASE + USER_HEAP_SIZE);
+}
+
+/*
+ * First touch of page va of a program segment. A read-only page wholly
+ * backed by the file is the archive's own frame, shared by every instance
+ * of the program; anything else is a private frame filled from the file
+ * and zeroed past it.
+ */
+static int map_image_page(unsigned int *pgd, const struct user_segment *s, unsigned int va,
+                          struct fault_stats *st) {
+    unsigned int attrs = PAGE_NORMAL | PAGE_NG | (s->flags & PF_X ? 0 : PAGE_XN);
+    unsigned int file_end = s->vaddr + s->filesz;
+    unsigned int from, to, pa;
+
+    if (!(s->flags & PF_W) && va < file_end &&
+        (va + PAGE_SIZE <= file_end || s->filesz == s->memsz)) {
+        pa = s->file + (va - s->vaddr);
+        page_get(pa);
+        if (map_page(pgd, va, pa, attrs | PAGE_AP(AP_PRIV_RW_USER_RO)) < 0) {
+            page_put(pa);
+            return -1;
+        }
+        st->file_maps++;
+        return 0;
+    }
+
+    pa = alloc_page();
+    if (!pa)
+        return -1;
+    from = va > s->vaddr ? va : s->vaddr;
+    to = va + PAGE_SIZE < file_end ? va + PAGE_SIZE : file_end;
+    if (from < to)
+        memcpy((void *)(pa + (from - va)), (const void *)(s->file + (from - s->vaddr)), to - from);
+    if (s->flags & PF_X) {
+        dcache_clean_range(pa, PAGE_SIZE);
+        icache_invalidate_all();
+    }
+    if (map_page(pgd, va, pa, attrs | PAGE_AP(s->flags & PF_W ? AP_PRIV_RW_USER_RW
+                                                              : AP_PRIV_RW_USER_RO)) < 0) {
+        free_page(pa);
+        return -1;
+    }
+    st->file_copies++;
+    return 0;
+}
+
+/*
+ * Resolve a fault on va in the current process: map a program page or a
+ * zeroed frame on first touch, or give a writer its own copy of a page
+ * fork left shared. access is FAULT_WRITE and/or FAULT_EXEC. Returns 0
+ * once the access can be retried, -1 if it is not allowed.
+ */
+int handle_user_fault(unsigned int va, int access) {
+    struct fault_stats *st = &fault_stats[smp_processor_id()];
+    unsigned int c0 = pmu_cycles();
+    unsigned int *pgd = current->pgd;
+    const struct user_segment *seg = 0;
+    unsigned int *pte, old, pa;
+
+    if (!pgd)
+        return -1;
+    if (current->image)
+        seg = image_segment(current->image, va);
+    if (!seg && !in_demand_area(va))
+        return -1;
+    if ((access & FAULT_WRITE) && seg && !(seg->flags & PF_W))
+        return -1;
+    if ((access & FAULT_EXEC) && !(seg && (seg->flags & PF_X)))
+        return -1;
+    va &= ~(PAGE_SIZE - 1);
+
+    pte = lookup_pte(pgd, va);
+    if ((!pte || !(*pte & SMALL_PAGE)) && seg) {
+        if (map_image_page(pgd, seg, va, st) < 0)
+            return -1;
+        st->file_cycles += pmu_cycles() - c0;
+        return 0;
+    }
+    if (!pte || !(*pte & SMALL_PAGE)) {
+        pa = alloc_page();
+        if (!pa || map_page(pgd, va, pa, USER_PAGE_ATTRS | PAGE_AP(AP_PRIV_RW_USER_RW)) < 0) {
+            if (pa)
+                free_page(pa);
+            return -1;
+        }
+        st->zero_fills++;
+        st->zero_cycles += pmu_cycles() - c0;
+        return 0;
+    }
+
+    // Present and readable: only a write to a read-only page is left
+    if (!(access & FAULT_WRITE) || ((*pte >> 4) & 3) == AP_PRIV_RW_USER_RW)
+        return 0;
+
+    old = *pte & ~(PAGE_SIZE - 1);
+    if (page_refs(old) == 1) {
+        // The other sharers already took their copies
+        map_page(pgd, va, old, USER_PAGE_ATTRS | PAGE_AP(AP_PRIV_RW_USER_RW));
+        st->cow_reuses++;
+    } else {
+        pa = alloc_page();
+        if (!pa)
+            return -1;
+        memcpy((void *)pa, (const void *)old, PAGE_SIZE);
+        map_page(pgd, va, pa, USER_PAGE_ATTRS | PAGE_AP(AP_PRIV_RW_USER_RW));
+        page_put(old);
+        st->cow_copies++;
+    }
+    st->cow_cycles += pmu_cycles() - c0;
+    return 0;
+}
+
+static const char *fault_name(unsigned int status) {
+    switch (status) {
+    case FS_ALIGNMENT:
+        return "alignment";
+    case FS_TRANSLATION_SECTION:
+    case FS_TRANSLATION_PAGE:
+        return "translation";
+    case FS_DOMAIN_SECTION:
+    case FS_DOMAIN_PAGE:
+        return "domain";
+    case FS_PERMISSION_SECTION:
+    case FS_PERMISSION_PAGE:
+        return "permission";
+    }
+    return "external";
+}
+
+// A task that makes a bad access ends as if it had called exit; the same
+// in kernel code stops the core
+static void bad_abort(const char *kind, struct abort_frame *f, unsigned int fsr, unsigned int far) {
+    printf("%s abort (%s) at pc %08x, address %08x, fsr %03x, pid %u\n", kind,
+           fault_name(FSR_STATUS(fsr)), f->pc, far, fsr, current->pid);
+
+    if ((f->cpsr & PSR_MODE_MASK) == PSR_MODE_USR) {
+        fault_stats[smp_processor_id()].kills++;
+        current->state = TASK_ZOMBIE;
+        schedule();
+    }
+    while (1)
+        asm volatile("wfe");
+}
+
+void do_data_abort(struct abort_frame *f) {
+    unsigned int dfsr, dfar, status;
+
+    asm volatile("mrc p15, 0, %0, c5, c0, 0" : "=r"(dfsr));
+    asm volatile("mrc p15, 0, %0, c6, c0, 0" : "=r"(dfar));
+    trace_event(TRACE_FAULT, dfar);
+
+    status = FSR_STATUS(dfsr);
+    if ((status == FS_TRANSLATION_SECTION || status == FS_TRANSLATION_PAGE ||
+         status == FS_PERMISSION_PAGE) &&
+        handle_user_fault(dfar, dfsr & FSR_WNR ? FAULT_WRITE : 0) == 0)
+        return;
+    bad_abort("data", f, dfsr, dfar);
+}
+
+// Program text is mapped on its first instruction fetch; nothing else a
+// task may execute is ever missing
+void do_prefetch_abort(struct abort_frame *f) {
+    unsigned int ifsr, ifar, status;
+
+    asm volatile("mrc p15, 0, %0, c5, c0, 1" : "=r"(ifsr));
+    asm volatile("mrc p15, 0, %0, c6, c0, 2" : "=r"(ifar));
+    trace_event(TRACE_FAULT, ifar);
+
+    status = FSR_STATUS(ifsr);
+    if ((status == FS_TRANSLATION_SECTION || status == FS_TRANSLATION_PAGE) &&
+        (f->cpsr & PSR_MODE_MASK) == PSR_MODE_USR &&
+        handle_user_fault(ifar, FAULT_EXEC) == 0)
+        return;
+    bad_abort("prefetch", f, ifsr, ifar);
+}
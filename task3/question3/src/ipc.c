@@ -0,0 +1,244 @@
+#include "ipc.h"
+#include "mm.h"
+#include "sched.h"
+#include "spinlock.h"
+#include "string.h"
+#include "translation.h"
+
+#define FUTEX_HASH      32
+
+/*
+ * A channel owns its ring page and keeps one reference on it; each
+ * process that maps it holds another, dropped by pgd_clear when it exits
+ * or execs. kring is a second, kernel-only ring that chan_send/chan_recv
+ * copy through; users counts the calls in ipc_map, ipc_send and ipc_recv,
+ * sleepers included. Once the channel has been used, the slot is free for
+ * ipc_create to reuse when nobody maps it, no call is inside it and kring
+ * holds no undelivered message.
+ */
+struct channel {
+    unsigned int page;
+    unsigned int kring;
+    int used;
+    int users;                  // Under lock
+    spinlock_t lock;            // kring, users and the waiters
+    struct wait_queue waitq;
+};
+
+// Waiters on all futexes that hash to the same bucket share one queue and
+// are all woken together; each re-checks its own word, as callers of
+// FUTEX_WAIT must anyway
+struct futex_bucket {
+    spinlock_t lock;
+    struct wait_queue waitq;
+};
+
+struct ipc_stats ipc_stats[NR_CPUS];
+
+static struct channel channels[IPC_MAX];
+static spinlock_t channels_lock = SPINLOCK_INIT;
+static struct futex_bucket futex_buckets[FUTEX_HASH];
+
+// Called with channels_lock held, so no new user can turn up meanwhile
+static int channel_idle(struct channel *c) {
+    struct ipc_ring *r = (struct ipc_ring *)c->kring;
+    unsigned int flags = spin_lock_irqsave(&c->lock);
+    int idle = c->used && !c->users && !c->waitq.head &&
+               page_refs(c->page) == 1 && r->head == r->tail;
+
+    spin_unlock_irqrestore(&c->lock, flags);
+    return idle;
+}
+
+// A new channel with an empty ring, or -ENOMEM
+int ipc_create(void) {
+    unsigned int flags = spin_lock_irqsave(&channels_lock);
+    int id = -ENOMEM;
+
+    for (int i = 0; i < IPC_MAX; i++) {
+        struct channel *c = &channels[i];
+
+        if (c->page && !channel_idle(c))
+            continue;
+        if (!c->page) {
+            c->page = alloc_page();
+            c->kring = alloc_page();
+            if (!c->page || !c->kring) {
+                if (c->page)
+                    free_page(c->page);
+                c->page = 0;
+                break;
+            }
+        } else {
+            memzero(c->page, PAGE_SIZE);
+            memzero(c->kring, PAGE_SIZE);
+        }
+        c->used = 0;
+        c->users = 0;
+        c->lock = (spinlock_t)SPINLOCK_INIT;
+        c->waitq = (struct wait_queue)WAIT_QUEUE_INIT;
+        id = i;
+        break;
+    }
+    spin_unlock_irqrestore(&channels_lock, flags);
+    return id;
+}
+
+// Channel id with a use taken on it, so ipc_create cannot reuse it until
+// channel_put; 0 if there is no such channel
+static struct channel *channel_get(int id) {
+    struct channel *c;
+    unsigned int flags, cflags;
+
+    if (id < 0 || id >= IPC_MAX)
+        return 0;
+    c = &channels[id];
+    flags = spin_lock_irqsave(&channels_lock);
+    if (!c->page) {
+        spin_unlock_irqrestore(&channels_lock, flags);
+        return 0;
+    }
+    cflags = spin_lock_irqsave(&c->lock);
+    c->users++;
+    c->used = 1;
+    spin_unlock_irqrestore(&c->lock, cflags);
+    spin_unlock_irqrestore(&channels_lock, flags);
+    return c;
+}
+
+static void channel_put(struct channel *c) {
+    unsigned int flags = spin_lock_irqsave(&c->lock);
+
+    c->users--;
+    spin_unlock_irqrestore(&c->lock, flags);
+}
+
+// Map channel id's ring into the caller, shared and writable, and return
+// its address. Mapping it again just returns the address.
+int ipc_map(int id) {
+    struct channel *c = channel_get(id);
+    unsigned int va = USER_IPC_BASE + id * PAGE_SIZE;
+    unsigned int *pte;
+    int ret = va;
+
+    if (!c)
+        return -EINVAL;
+    pte = lookup_pte(current->pgd, va);
+    if (!pte || !(*pte & SMALL_PAGE)) {
+        page_get(c->page);
+        if (map_page(current->pgd, va, c->page,
+                     PAGE_NORMAL | PAGE_XN | PAGE_NG | PAGE_AP(AP_PRIV_RW_USER_RW)) < 0) {
+            page_put(c->page);
+            ret = -ENOMEM;
+        }
+    }
+    channel_put(c);
+    return ret;
+}
+
+/*
+ * The copying baseline: the message goes from the caller into the
+ * channel's kernel ring and from there to the receiver, the way a pipe
+ * would carry it, with both sides sleeping on the channel's queue while
+ * the ring is full or empty. buf has been checked by the caller.
+ */
+int ipc_send(int id, const void *buf, unsigned int len) {
+    struct channel *c = channel_get(id);
+    struct ipc_ring *r;
+    struct ipc_msg *m;
+    unsigned int flags;
+
+    if (!c)
+        return -EINVAL;
+    if (len > IPC_MSG_MAX) {
+        channel_put(c);
+        return -EINVAL;
+    }
+    r = (struct ipc_ring *)c->kring;
+
+    flags = spin_lock_irqsave(&c->lock);
+    while (r->head - r->tail == IPC_SLOTS)
+        sleep_on(&c->waitq, &c->lock);
+    m = &r->slot[r->head & (IPC_SLOTS - 1)];
+    memcpy(m->data, buf, len);
+    m->len = len;
+    r->head++;
+    wake_up(&c->waitq);
+    c->users--;
+    spin_unlock_irqrestore(&c->lock, flags);
+
+    ipc_stats[smp_processor_id()].copies++;
+    return len;
+}
+
+// Returns the message length; anything past len is dropped
+int ipc_recv(int id, void *buf, unsigned int len) {
+    struct channel *c = channel_get(id);
+    struct ipc_ring *r;
+    struct ipc_msg *m;
+    unsigned int flags;
+
+    if (!c)
+        return -EINVAL;
+    r = (struct ipc_ring *)c->kring;
+
+    flags = spin_lock_irqsave(&c->lock);
+    while (r->head == r->tail)
+        sleep_on(&c->waitq, &c->lock);
+    m = &r->slot[r->tail & (IPC_SLOTS - 1)];
+    if (len > m->len)
+        len = m->len;
+    memcpy(buf, m->data, len);
+    r->tail++;
+    wake_up(&c->waitq);
+    c->users--;
+    spin_unlock_irqrestore(&c->lock, flags);
+    return len;
+}
+
+/*
+ * Futexes are keyed by physical address, so two processes waiting on the
+ * same word of a shared page meet in the same bucket whatever address
+ * each maps it at. Pages outside the private tables are the identity
+ * mapped kernel image (__user_data).
+ */
+static struct futex_bucket *futex_bucket(unsigned int uaddr) {
+    unsigned int *pte = lookup_pte(current->pgd, uaddr);
+    unsigned int pa = uaddr;
+
+    if (pte && (*pte & SMALL_PAGE))
+        pa = (*pte & ~(PAGE_SIZE - 1)) | (uaddr & (PAGE_SIZE - 1));
+    return &futex_buckets[((pa >> 2) ^ (pa >> PAGE_SHIFT)) & (FUTEX_HASH - 1)];
+}
+
+/*
+ * Sleep unless *uaddr has moved on from val. The word is read under the
+ * bucket lock, which futex_wake also takes, so a change plus wake-up from
+ * the other side lands either before the check or after the sleeper is
+ * queued. uaddr has been checked and faulted in by the caller.
+ */
+int futex_wait(unsigned int uaddr, unsigned int val) {
+    struct futex_bucket *b = futex_bucket(uaddr);
+    unsigned int flags = spin_lock_irqsave(&b->lock);
+
+    ipc_stats[smp_processor_id()].futex_calls++;
+    if (*(volatile unsigned int *)uaddr != val) {
+        spin_unlock_irqrestore(&b->lock, flags);
+        return -EAGAIN;
+    }
+    ipc_stats[smp_processor_id()].futex_sleeps++;
+    sleep_on(&b->waitq, &b->lock);
+    spin_unlock_irqrestore(&b->lock, flags);
+    return 0;
+}
+
+// Wake everything sleeping in uaddr's bucket; returns how many that was
+int futex_wake(unsigned int uaddr) {
+    struct futex_bucket *b = futex_bucket(uaddr);
+    unsigned int flags = spin_lock_irqsave(&b->lock);
+    int n = wake_up(&b->waitq);
+
+    spin_unlock_irqrestore(&b->lock, flags);
+    ipc_stats[smp_processor_id()].futex_calls++;
+    return n;
+}
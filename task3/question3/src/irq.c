@@ -0,0 +1,35 @@
+#include "irq.h"
+#include "utils.h"
+#include "mini_uart.h"
+#include "sched.h"
+#include "smp.h"
+#include "trace.h"
+#include "timer.h"
+#include "peripherals/irq.h"
+
+void irq_init(void) {
+    // Start with every GPU interrupt masked; drivers enable their own lines
+    put32(DISABLE_IRQS_1, 0xFFFFFFFF);
+    put32(DISABLE_IRQS_2, 0xFFFFFFFF);
+    put32(DISABLE_BASIC_IRQS, 0xFFFFFFFF);
+}
+
+// Called from irq_handler in vectors.S with the interrupted context saved.
+// GPU interrupts (the UART) are routed to core 0 only.
+void handle_irq(void) {
+    unsigned int source = get32(CORE_IRQ_SOURCE(smp_processor_id()));
+
+    trace_event(TRACE_IRQ_ENTER, source);
+    if (source & LOCAL_IRQ_CNTV)
+        timer_handle_irq();
+    if (source & LOCAL_IRQ_MBOX0)
+        smp_handle_ipi();
+
+    if (source & LOCAL_IRQ_GPU) {
+        if (get32(IRQ_PENDING_2) & IRQ_2_UART0)
+            uart_handle_irq();
+        if (get32(IRQ_PENDING_1) & IRQ_1_DMA(UART_DMA_CHANNEL))
+            uart_dma_irq();
+    }
+    trace_event(TRACE_IRQ_EXIT, source);
+}
@@ -1,25 +1,62 @@
 #include "mm.h"
 #include "translation.h"
 #include "printf.h"
+#include "mini_uart.h"
+#include "irq.h"
+#include "pmu.h"
+#include "sched.h"
+#include "smp.h"
+#include "exec.h"
+#include "trace.h"
+#ifdef BENCH
+#include "bench.h"
+#endif
 
-extern void switch_to_user_mode();
+extern char bss_end[];
 
 void kernel_main(void) {
-    // Setup page tables with proper access control
-    map_kernel_and_user_space();
+    // Frames above the kernel image feed page tables and user pages
+    page_alloc_init((unsigned int)bss_end, RAM_END);
 
-    // Enable MMU
+    // Patch the user pages into the prebuilt tables and enable the MMU
     mmu_init();
 
-    // Initialize UART for printf
-    printf_init();
+    // Interrupt-driven UART: queue output and let the TX IRQ drain it
+    pmu_init();
+    irq_init();
+    uart_init();
+    enable_irq();
 
     // Kernel prints
     printf("Hello from EL1 (Kernel Mode)\n");
 
-    // Switch to EL0 and run user code
-    switch_to_user_mode();
+    // Check the embedded archive and pin its frames for sharing
+    initramfs_init();
 
-    // Should never return
-    while (1);
+    // Round-robin over EL0 tasks, preempted by the generic timer
+    sched_init(SCHED_SLICE_US);
+
+    // Cores 1-3 come up idle and steal work from core 0's run queue
+    smp_init();
+
+#ifdef BENCH
+    bench_run_all();
+#endif
+
+#ifdef TRACE
+    // Record everything from here until tracedump asks for the dump
+    trace_start();
+#endif
+
+    // EL0 programs from the initramfs: the syscall demo plus two tickers
+    // sharing the CPUs (and their text pages)
+    task_exec(image_lookup("hello"));
+    task_exec(image_lookup("ticker"));
+    task_exec(image_lookup("ticker"));
+#ifdef TRACE
+    task_exec(image_lookup("tracedump"));
+#endif
+
+    // The boot context idles from here on and never returns
+    sched_idle();
 }
@@ -0,0 +1,200 @@
+#include "kmalloc.h"
+#include "mm.h"
+#include "spinlock.h"
+#include "string.h"
+
+// page_tag values: slab frames carry their class + 1, the first frame of a
+// large allocation its order with LARGE_TAG set
+#define LARGE_TAG       0x80
+
+// Small classes fit in one page; from 256 bytes on a slab is four pages, so
+// the header's slot wastes at most a sixteenth of it
+#define SLAB_ORDER(cls) ((cls) + KMALLOC_MIN_SHIFT >= 8 ? 2 : 0)
+
+// At the start of every slab, in the slot(s) of its first object
+struct slab {
+    struct slab *next;          // On the cache's partial list
+    void *free;                 // Free objects, linked through their first word
+    unsigned int inuse;         // Objects out, counting those in magazines
+    unsigned int cls;
+};
+
+struct kmem_cache {
+    spinlock_t lock;
+    struct slab *partial;       // Slabs with a free object
+};
+
+struct magazine {
+    unsigned int count;
+    void *objs[MAGAZINE_SIZE];
+};
+
+static struct kmem_cache caches[KMALLOC_CLASSES];
+static struct magazine magazines[NR_CPUS][KMALLOC_CLASSES];
+static spinlock_t stats_lock = SPINLOCK_INIT;   // kmalloc_stats, off the fast path
+
+struct kmalloc_stats kmalloc_stats;
+
+static unsigned int size_class(unsigned int size) {
+    unsigned int cls = 0;
+
+    while ((1u << (cls + KMALLOC_MIN_SHIFT)) < size)
+        cls++;
+    return cls;
+}
+
+static void stat_add(unsigned int *counter, int n) {
+    unsigned int flags = spin_lock_irqsave(&stats_lock);
+
+    *counter += n;
+    spin_unlock_irqrestore(&stats_lock, flags);
+}
+
+// A fresh slab with every object but the header's slot(s) on its free
+// list, or 0 when out of memory; the caller holds the cache lock
+static struct slab *slab_create(unsigned int cls) {
+    unsigned int order = SLAB_ORDER(cls);
+    unsigned int size = 1u << (cls + KMALLOC_MIN_SHIFT);
+    unsigned int bytes = PAGE_SIZE << order;
+    unsigned int first = (sizeof(struct slab) + size - 1) & ~(size - 1);
+    unsigned int base = alloc_pages(order);
+    struct slab *s = (struct slab *)base;
+    void **link = &s->free;
+
+    if (!base)
+        return 0;
+    for (unsigned int off = first; off < bytes; off += size) {
+        *link = (void *)(base + off);
+        link = (void **)(base + off);
+    }
+    *link = 0;
+    s->cls = cls;
+    for (unsigned int i = 0; i < (1u << order); i++)
+        page_set_tag(base + i * PAGE_SIZE, cls + 1);
+    stat_add(&kmalloc_stats.slab_pages, 1 << order);
+    return s;
+}
+
+static struct slab *slab_of(void *p, unsigned int cls) {
+    return (struct slab *)((unsigned int)p & ~((PAGE_SIZE << SLAB_ORDER(cls)) - 1));
+}
+
+// Fill an empty magazine halfway from the cache's slabs
+static void magazine_refill(struct magazine *m, unsigned int cls) {
+    struct kmem_cache *c = &caches[cls];
+
+    spin_lock(&c->lock);
+    while (m->count < MAGAZINE_SIZE / 2) {
+        struct slab *s = c->partial;
+        if (!s && !(s = c->partial = slab_create(cls)))
+            break;
+        m->objs[m->count++] = s->free;
+        s->free = *(void **)s->free;
+        s->inuse++;
+        if (!s->free)
+            c->partial = s->next;
+    }
+    spin_unlock(&c->lock);
+    stat_add(&kmalloc_stats.refills, 1);
+}
+
+// Give the older half of a full magazine back to the slabs. A slab that
+// empties is released, unless it is the cache's only one with room.
+static void magazine_drain(struct magazine *m, unsigned int cls) {
+    struct kmem_cache *c = &caches[cls];
+    unsigned int n = MAGAZINE_SIZE / 2;
+    unsigned int freed = 0;
+
+    spin_lock(&c->lock);
+    for (unsigned int i = 0; i < n; i++) {
+        void *p = m->objs[i];
+        struct slab *s = slab_of(p, cls);
+
+        if (!s->free) {
+            s->next = c->partial;
+            c->partial = s;
+        }
+        *(void **)p = s->free;
+        s->free = p;
+        if (--s->inuse == 0 && !(c->partial == s && !s->next)) {
+            struct slab **pp = &c->partial;
+            while (*pp != s)
+                pp = &(*pp)->next;
+            *pp = s->next;
+            free_pages((unsigned int)s, SLAB_ORDER(cls));
+            freed += 1 << SLAB_ORDER(cls);
+        }
+    }
+    spin_unlock(&c->lock);
+
+    for (unsigned int i = n; i < m->count; i++)
+        m->objs[i - n] = m->objs[i];
+    m->count -= n;
+    stat_add(&kmalloc_stats.drains, 1);
+    if (freed)
+        stat_add(&kmalloc_stats.slab_pages, -(int)freed);
+}
+
+static void *kmalloc_large(unsigned int size) {
+    unsigned int order = 0;
+    unsigned int pa;
+
+    while (((unsigned int)PAGE_SIZE << order) < size)
+        order++;
+    pa = alloc_pages(order);
+    if (!pa)
+        return 0;
+    page_set_tag(pa, LARGE_TAG | order);
+    stat_add(&kmalloc_stats.large_pages, 1 << order);
+    return (void *)pa;
+}
+
+// Not zeroed, except for large sizes, which come straight from alloc_pages
+void *kmalloc(unsigned int size) {
+    struct magazine *m;
+    unsigned int cls, flags;
+    void *p = 0;
+
+    if (size > KMALLOC_MAX)
+        return kmalloc_large(size);
+
+    cls = size_class(size);
+    flags = irq_save();
+    m = &magazines[smp_processor_id()][cls];
+    if (!m->count)
+        magazine_refill(m, cls);
+    if (m->count)
+        p = m->objs[--m->count];
+    irq_restore(flags);
+    return p;
+}
+
+void *kzalloc(unsigned int size) {
+    void *p = kmalloc(size);
+
+    if (p && size <= KMALLOC_MAX)
+        memset(p, 0, size);
+    return p;
+}
+
+void kfree(void *p) {
+    unsigned int tag, cls, flags;
+    struct magazine *m;
+
+    if (!p)
+        return;
+    tag = page_tag((unsigned int)p);
+    if (tag & LARGE_TAG) {
+        stat_add(&kmalloc_stats.large_pages, -(1 << (tag & ~LARGE_TAG)));
+        free_pages((unsigned int)p, tag & ~LARGE_TAG);
+        return;
+    }
+
+    cls = tag - 1;
+    flags = irq_save();
+    m = &magazines[smp_processor_id()][cls];
+    if (m->count == MAGAZINE_SIZE)
+        magazine_drain(m, cls);
+    m->objs[m->count++] = p;
+    irq_restore(flags);
+}
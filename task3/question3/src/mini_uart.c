@@ -1,58 +1,557 @@
 #include "mini_uart.h"
 #include "utils.h"
-#include "peripherals/base.h"
-
-#define AUX_ENABLES     (PERIPHERAL_BASE + 0x215004)
-#define AUX_MU_IO_REG   (PERIPHERAL_BASE + 0x215040)
-#define AUX_MU_IER_REG  (PERIPHERAL_BASE + 0x215044)
-#define AUX_MU_IIR_REG  (PERIPHERAL_BASE + 0x215048)
-#define AUX_MU_LCR_REG  (PERIPHERAL_BASE + 0x21504C)
-#define AUX_MU_MCR_REG  (PERIPHERAL_BASE + 0x215050)
-#define AUX_MU_LSR_REG  (PERIPHERAL_BASE + 0x215054)
-#define AUX_MU_CNTL_REG (PERIPHERAL_BASE + 0x215060)
-#define AUX_MU_BAUD_REG (PERIPHERAL_BASE + 0x215068)
-#define GPFSEL1         (PERIPHERAL_BASE + 0x200004)
-#define GPPUD           (PERIPHERAL_BASE + 0x200094)
-#define GPPUDCLK0       (PERIPHERAL_BASE + 0x200098)
+#include "irq.h"
+#include "pmu.h"
+#include "timer.h"
+#include "ring.h"
+#include "smp.h"
+#include "spinlock.h"
+#include "sched.h"
+#include "syscall.h"
+#include "cache.h"
+#include "dma.h"
+#include "peripherals/mini_uart.h"
+#include "peripherals/dma.h"
+#include "peripherals/gpio.h"
+#include "peripherals/irq.h"
+
+// UART0_FR bits
+#define FR_RXFE         (1 << 4)    // RX FIFO empty
+#define FR_TXFF         (1 << 5)    // TX FIFO full
+#define FR_BUSY         (1 << 3)
+
+// UART0_IMSC / UART0_MIS / UART0_ICR bits
+#define INT_RX          (1 << 4)
+#define INT_TX          (1 << 5)
+#define INT_RT          (1 << 6)    // RX timeout: FIFO below trigger but idle
+
+// UART0_CR bits
+#define CR_UARTEN       (1 << 0)
+#define CR_LBE          (1 << 7)    // TX looped back into RX
+#define CR_TXE          (1 << 8)
+#define CR_RXE          (1 << 9)
+
+// UART0_DMACR bits
+#define DMACR_TXDMAE    (1 << 1)
+
+// UART0_IFLS: TX interrupt when FIFO drains to 1/8, RX interrupt at 1/2 full
+#define IFLS_TX_1_8     (0 << 0)
+#define IFLS_RX_1_2     (2 << 3)
+
+static struct ring tx_ring;
+static struct ring rx_ring;
+
+// Any core may write, so the rings' producer and consumer sides are each
+// taken by one core at a time under this lock (the IRQ runs on core 0)
+static spinlock_t uart_lock = SPINLOCK_INIT;
+
+struct uart_stats uart_stats;
+unsigned long long uart_first_tx_ticks;
+
+/*
+ * Line discipline, run by the RX interrupt. In cooked mode it edits the
+ * current line (backspace, ^U) and moves it into rx_ring only once it is
+ * complete, so readers wake once per line. Echo from one FIFO drain is
+ * queued as a batch and pushed with a single pump. Raw mode passes every
+ * byte straight through. Readers and pollers sleep on rx_waitq until input
+ * arrives, or on tx_waitq until the TX pump has made room.
+ */
+#define LDISC_LINE_MAX  128
+#define CTRL_U          0x15
+
+static unsigned int ldisc_mode = UART_COOKED | UART_ECHO;
+static char ldisc_line[LDISC_LINE_MAX];
+static unsigned int ldisc_len;
+static unsigned int rx_lines;           // Complete lines in rx_ring
+static struct wait_queue rx_waitq = WAIT_QUEUE_INIT;
+static struct wait_queue tx_waitq = WAIT_QUEUE_INIT;
+
+/*
+ * DMA transmit. The engine moves 32-bit words and every word written to
+ * UART0_DR sends its low byte, so bytes are widened into a ring of word
+ * blocks, each with its own control block. Blocks are counted with
+ * free-running numbers: [dma_reaped, dma_sent) belong to the engine,
+ * [dma_sent, dma_closed) are full and waiting for it, and block dma_closed
+ * is being filled. While dma_claimed is set the FIFO belongs to the
+ * engine and uart_tx_pump leaves it alone.
+ */
+#define UART_DMA_BLOCKS     16
+#define UART_DMA_BLOCK      256     // Bytes (words) per control block
+
+static struct dma_cb dma_cbs[UART_DMA_BLOCKS];
+static unsigned int dma_words[UART_DMA_BLOCKS][UART_DMA_BLOCK] __attribute__((aligned(64)));
+static unsigned int dma_len[UART_DMA_BLOCKS];
+static unsigned int dma_reaped, dma_sent, dma_closed, dma_fill;
+static int dma_claimed;
 
 void uart_init() {
-    put32(AUX_ENABLES, 1);                 // Enable mini UART
-    put32(AUX_MU_CNTL_REG, 0);             // Disable TX/RX during config
-    put32(AUX_MU_IER_REG, 0);              // Disable interrupts
-    put32(AUX_MU_LCR_REG, 3);              // 8-bit mode
-    put32(AUX_MU_MCR_REG, 0);              // No RTS/CTS
-    put32(AUX_MU_BAUD_REG, 270);           // 115200 baud @ 250 MHz
-
-    // GPIO14 (TXD) and GPIO15 (RXD) to ALT5
+    put32(UART0_CR, 0);                     // Disable UART0 during config
+
+    // GPIO14 (TXD) and GPIO15 (RXD) to ALT0
     unsigned int selector = get32(GPFSEL1);
     selector &= ~(7 << 12);                // clear GPIO14
-    selector |= 2 << 12;                   // ALT5
+    selector |= 4 << 12;                   // ALT0
     selector &= ~(7 << 15);                // clear GPIO15
-    selector |= 2 << 15;                   // ALT5
+    selector |= 4 << 15;                   // ALT0
     put32(GPFSEL1, selector);
 
     put32(GPPUD, 0);                       // Disable pull-up/down
-    delay(150);
+    udelay(1);                             // >= 150 cycles of set-up time
     put32(GPPUDCLK0, (1 << 14) | (1 << 15));
-    delay(150);
+    udelay(1);
     put32(GPPUDCLK0, 0);
 
-    put32(AUX_MU_CNTL_REG, 3);             // Enable TX and RX
+    put32(UART0_ICR, 0x7FF);                // Clear pending interrupts
+
+    // 115200 baud @ 48 MHz UART clock: 48000000 / (16 * 115200) = 26.0417
+    put32(UART0_IBRD, 26);
+    put32(UART0_FBRD, 3);
+
+    put32(UART0_LCRH, (1 << 4) | (3 << 5)); // FIFOs on, 8N1
+    put32(UART0_IFLS, IFLS_TX_1_8 | IFLS_RX_1_2);
+
+    // RX interrupts stay on; TX is unmasked only while tx_ring has data
+    put32(UART0_IMSC, INT_RX | INT_RT);
+    put32(UART0_CR, CR_UARTEN | CR_TXE | CR_RXE);
+
+    put32(ENABLE_IRQS_2, IRQ_2_UART0);
+    dma_channel_init(UART_DMA_CHANNEL);
+}
+
+// Move queued bytes into the hardware FIFO. Runs with uart_lock held, so it
+// is always the only consumer of tx_ring.
+static void uart_tx_pump(void) {
+    unsigned char c;
+
+    if (dma_claimed) {
+        put32(UART0_IMSC, get32(UART0_IMSC) & ~INT_TX);
+        return;
+    }
+
+    while (!(get32(UART0_FR) & FR_TXFF) && ring_get(&tx_ring, &c)) {
+        if (!uart_first_tx_ticks)
+            uart_first_tx_ticks = timer_count();
+        put32(UART0_DR, c);
+        uart_stats.tx_bytes++;
+    }
+
+    if (ring_count(&tx_ring))
+        put32(UART0_IMSC, get32(UART0_IMSC) | INT_TX);
+    else
+        put32(UART0_IMSC, get32(UART0_IMSC) & ~INT_TX);
+
+    // Pollers waiting for room to write
+    if (tx_waitq.head && ring_space(&tx_ring))
+        wake_up(&tx_waitq);
+}
+
+static void ldisc_echo(const char *s, unsigned int n) {
+    if (ldisc_mode & UART_ECHO)
+        while (n-- && ring_put(&tx_ring, *s++));
+}
+
+static void ldisc_erase(void) {
+    if (ldisc_len) {
+        ldisc_len--;
+        ldisc_echo("\b \b", 3);
+    }
+}
+
+// Cooked input; returns 1 once a line has been moved into rx_ring
+static int ldisc_input(unsigned char c) {
+    if (c == '\r')
+        c = '\n';
+
+    if (c == '\b' || c == 0x7F) {
+        ldisc_erase();
+        return 0;
+    }
+    if (c == CTRL_U) {
+        while (ldisc_len)
+            ldisc_erase();
+        return 0;
+    }
+    if (c != '\n') {
+        if (ldisc_len == LDISC_LINE_MAX) {
+            uart_stats.rx_dropped++;
+            return 0;
+        }
+        ldisc_line[ldisc_len++] = c;
+        ldisc_echo((char *)&c, 1);
+        return 0;
+    }
+
+    ldisc_echo("\r\n", 2);
+    if (ring_space(&rx_ring) < ldisc_len + 1) {
+        uart_stats.rx_dropped += ldisc_len + 1;
+        ldisc_len = 0;
+        return 0;
+    }
+    for (unsigned int i = 0; i < ldisc_len; i++)
+        ring_put(&rx_ring, ldisc_line[i]);
+    ring_put(&rx_ring, '\n');
+    ldisc_len = 0;
+    rx_lines++;
+    return 1;
+}
+
+// Drain the RX FIFO through the line discipline. Runs with uart_lock held.
+static void uart_rx_pump(void) {
+    unsigned int echo = tx_ring.head;
+    int ready = 0;
+
+    while (!(get32(UART0_FR) & FR_RXFE)) {
+        unsigned char c = get32(UART0_DR) & 0xFF;
+
+        uart_stats.rx_bytes++;
+        if (ldisc_mode & UART_COOKED)
+            ready |= ldisc_input(c);
+        else if (ring_put(&rx_ring, c))
+            ready = 1;
+        else
+            uart_stats.rx_dropped++;
+    }
+
+    if (tx_ring.head != echo)
+        uart_tx_pump();
+    if (ready) {
+        uart_stats.rx_ready_ticks = timer_count();
+        wake_up(&rx_waitq);
+    }
+}
+
+// What a read or poll would find; uart_lock held
+static unsigned int uart_ready(void) {
+    unsigned int ready = 0;
+
+    if (ldisc_mode & UART_COOKED ? rx_lines : ring_count(&rx_ring))
+        ready |= POLLIN;
+    if (ring_space(&tx_ring))
+        ready |= POLLOUT;
+    return ready;
+}
+
+static int rx_take(unsigned char *c) {
+    if (!ring_get(&rx_ring, c))
+        return 0;
+    if (*c == '\n' && (ldisc_mode & UART_COOKED))
+        rx_lines--;
+    return 1;
+}
+
+void uart_handle_irq(void) {
+    unsigned int start = pmu_cycles();
+    unsigned int mis = get32(UART0_MIS);
+
+    spin_lock(&uart_lock);
+    if (mis & (INT_RX | INT_RT))
+        uart_rx_pump();
+    if (mis & INT_TX)
+        uart_tx_pump();
+    spin_unlock(&uart_lock);
+
+    put32(UART0_ICR, mis);
+    uart_stats.irqs++;
+    uart_stats.irq_cycles += pmu_cycles() - start;
+}
+
+/*
+ * Wait for the TX interrupt to make room, with IRQs masked and uart_lock
+ * released. WFI wakes on a pending IRQ even while CPSR.I is set, so core 0
+ * can wait in SVC mode; the other cores never see the UART IRQ and instead
+ * wake on the SEV from core 0's unlock once its handler has pumped.
+ */
+static void uart_wait(void) {
+    if (smp_processor_id() == 0)
+        asm volatile("wfi");
+    else
+        asm volatile("wfe");
+}
+
+void uart_write(const char *buf, unsigned int len) {
+    unsigned int flags;
+    int full;
+
+    while (len) {
+        // Queue as much as fits, then kick the FIFO once for the whole batch
+        flags = spin_lock_irqsave(&uart_lock);
+        while (len && ring_put(&tx_ring, *buf)) {
+            buf++;
+            len--;
+        }
+        uart_tx_pump();
+        full = len && !ring_space(&tx_ring);
+        spin_unlock(&uart_lock);
+
+        if (full)
+            uart_wait();
+        irq_restore(flags);
+    }
 }
 
 void uart_send(char c) {
-    while (!(get32(AUX_MU_LSR_REG) & 0x20));
-    put32(AUX_MU_IO_REG, c);
+    uart_write(&c, 1);
+}
+
+// Wait until every queued byte has left the transmitter
+void uart_flush(void) {
+    unsigned int flags;
+
+    while (ring_count(&tx_ring)) {
+        flags = spin_lock_irqsave(&uart_lock);
+        uart_tx_pump();
+        spin_unlock(&uart_lock);
+        if (ring_count(&tx_ring))
+            uart_wait();
+        irq_restore(flags);
+    }
+    while (get32(UART0_FR) & FR_BUSY);
+}
+
+// Bypass the queue: used before IRQs are up and as the benchmark baseline
+void uart_send_polled(char c) {
+    while (get32(UART0_FR) & FR_TXFF);
+    if (!uart_first_tx_ticks)
+        uart_first_tx_ticks = timer_count();
+    put32(UART0_DR, c);
+}
+
+// Hand every closed block to the engine as one chain, interrupting at the
+// end of the last. Runs with uart_lock held and the channel idle.
+static void uart_dma_kick(void) {
+    unsigned int first = dma_sent % UART_DMA_BLOCKS;
+
+    if (dma_sent != dma_reaped || dma_sent == dma_closed)
+        return;
+
+    for (unsigned int n = dma_sent; n != dma_closed; n++) {
+        unsigned int i = n % UART_DMA_BLOCKS;
+        struct dma_cb *cb = &dma_cbs[i];
+
+        cb->ti = DMA_TI_SRC_INC | DMA_TI_DEST_DREQ | DMA_TI_WAIT_RESP |
+                 DMA_TI_PERMAP(DMA_DREQ_UART_TX);
+        cb->source_ad = dma_bus_addr(dma_words[i]);
+        cb->dest_ad = dma_bus_periph(UART0_DR);
+        cb->txfr_len = dma_len[i] * 4;
+        cb->stride = 0;
+        if (n + 1 == dma_closed) {
+            cb->ti |= DMA_TI_INTEN;
+            cb->nextconbk = 0;
+        } else {
+            cb->nextconbk = dma_bus_addr(&dma_cbs[(n + 1) % UART_DMA_BLOCKS]);
+        }
+        dcache_clean_range((unsigned int)dma_words[i], dma_len[i] * 4);
+        dcache_clean_range((unsigned int)cb, sizeof(*cb));
+    }
+
+    dma_sent = dma_closed;
+    dma_start(UART_DMA_CHANNEL, &dma_cbs[first]);
+}
+
+// Retire the running chain once the engine has stopped and start the next
+static void uart_dma_reap(void) {
+    if (dma_reaped == dma_sent || !dma_done(UART_DMA_CHANNEL))
+        return;
+    dma_ack(UART_DMA_CHANNEL);
+    dma_reaped = dma_sent;
+    uart_dma_kick();
+}
+
+void uart_dma_irq(void) {
+    unsigned int start = pmu_cycles();
+
+    spin_lock(&uart_lock);
+    uart_dma_reap();
+    spin_unlock(&uart_lock);
+
+    uart_stats.dma_irqs++;
+    uart_stats.dma_cycles += pmu_cycles() - start;
+}
+
+/*
+ * Exclusive DMA output for binary dumps: wait for the queue to drain, then
+ * claim the FIFO so no other core's output lands inside the frame. Writers
+ * keep queueing meanwhile and are pumped again by uart_dma_end. Waiters
+ * reap by polling as well, since syscalls run with IRQs masked.
+ */
+void uart_dma_begin(void) {
+    unsigned int flags;
+    int claimed = 0;
+
+    while (!claimed) {
+        flags = spin_lock_irqsave(&uart_lock);
+        uart_tx_pump();
+        if (!dma_claimed && !ring_count(&tx_ring)) {
+            dma_claimed = claimed = 1;
+            put32(UART0_DMACR, DMACR_TXDMAE);
+        }
+        spin_unlock(&uart_lock);
+        if (!claimed)
+            uart_wait();
+        irq_restore(flags);
+    }
+}
+
+void uart_dma_write(const void *buf, unsigned int len) {
+    const unsigned char *p = buf;
+    unsigned int flags, start;
+    int full;
+
+    while (len) {
+        flags = spin_lock_irqsave(&uart_lock);
+        start = pmu_cycles();
+        uart_dma_reap();
+        while (len && dma_closed - dma_reaped < UART_DMA_BLOCKS) {
+            unsigned int *w = dma_words[dma_closed % UART_DMA_BLOCKS];
+
+            while (len && dma_fill < UART_DMA_BLOCK) {
+                w[dma_fill++] = *p++;
+                len--;
+                uart_stats.dma_bytes++;
+            }
+            if (dma_fill == UART_DMA_BLOCK) {
+                dma_len[dma_closed % UART_DMA_BLOCKS] = dma_fill;
+                dma_closed++;
+                dma_fill = 0;
+            }
+        }
+        uart_dma_kick();
+        full = len != 0;
+        uart_stats.dma_cycles += pmu_cycles() - start;
+        spin_unlock(&uart_lock);
+
+        if (full)
+            uart_wait();
+        irq_restore(flags);
+    }
+}
+
+// Send the partly filled block, wait for the engine and the transmitter,
+// then give the FIFO back to the queue
+void uart_dma_end(void) {
+    unsigned int flags, start;
+    int busy = 1;
+
+    while (busy) {
+        flags = spin_lock_irqsave(&uart_lock);
+        start = pmu_cycles();
+        if (dma_fill && dma_closed - dma_reaped < UART_DMA_BLOCKS) {
+            dma_len[dma_closed % UART_DMA_BLOCKS] = dma_fill;
+            dma_closed++;
+            dma_fill = 0;
+        }
+        uart_dma_reap();
+        uart_dma_kick();
+        busy = dma_fill || dma_reaped != dma_closed;
+        uart_stats.dma_cycles += pmu_cycles() - start;
+        spin_unlock(&uart_lock);
+
+        if (busy)
+            uart_wait();
+        irq_restore(flags);
+    }
+    while (get32(UART0_FR) & FR_BUSY);
+
+    flags = spin_lock_irqsave(&uart_lock);
+    put32(UART0_DMACR, 0);
+    dma_claimed = 0;
+    uart_tx_pump();
+    spin_unlock_irqrestore(&uart_lock, flags);
 }
 
 char uart_recv() {
-    while (!(get32(AUX_MU_LSR_REG) & 0x01));
-    return (char)(get32(AUX_MU_IO_REG) & 0xFF);
+    unsigned char c;
+    unsigned int flags;
+    int empty;
+
+    while (1) {
+        flags = spin_lock_irqsave(&uart_lock);
+        if ((uart_ready() & POLLIN) && rx_take(&c)) {
+            spin_unlock_irqrestore(&uart_lock, flags);
+            return (char)c;
+        }
+        uart_rx_pump();
+        empty = !(uart_ready() & POLLIN);
+        spin_unlock(&uart_lock);
+
+        if (empty)
+            uart_wait();
+        irq_restore(flags);
+    }
+}
+
+/*
+ * Console read for tasks: sleep until a line (raw mode: any byte) is in,
+ * then copy at most len bytes. A cooked read stops after the newline, and
+ * the rest of a longer line is left for the next read.
+ */
+unsigned int uart_read(char *buf, unsigned int len) {
+    unsigned int flags = spin_lock_irqsave(&uart_lock);
+    unsigned int n = 0;
+    unsigned char c;
+
+    if (!(uart_ready() & POLLIN)) {
+        do
+            sleep_on(&rx_waitq, &uart_lock);
+        while (!(uart_ready() & POLLIN));
+        uart_stats.rx_wakeups++;
+        uart_stats.rx_resume_ticks = timer_count();
+    }
+    while (n < len && rx_take(&c)) {
+        buf[n++] = c;
+        if (c == '\n' && (ldisc_mode & UART_COOKED))
+            break;
+    }
+    spin_unlock_irqrestore(&uart_lock, flags);
+    return n;
+}
+
+// The POLLIN/POLLOUT bits of events that are ready. With block set and
+// none ready, sleep once first, until deadline at the latest (0: none);
+// the caller loops. A full TX ring always drains, so waiting for POLLOUT
+// takes precedence.
+unsigned int uart_poll(unsigned int events, int block, unsigned long long deadline) {
+    unsigned int flags = spin_lock_irqsave(&uart_lock);
+    unsigned int ready = uart_ready() & events;
+
+    if (!ready && block) {
+        sleep_on_timeout(events & POLLOUT ? &tx_waitq : &rx_waitq, &uart_lock, deadline);
+        ready = uart_ready() & events;
+    }
+    spin_unlock_irqrestore(&uart_lock, flags);
+    return ready;
 }
 
+// Switching modes drops pending input and the line being edited
+void uart_set_mode(unsigned int mode) {
+    unsigned int flags = spin_lock_irqsave(&uart_lock);
+
+    ldisc_mode = mode;
+    ldisc_len = 0;
+    rx_lines = 0;
+    rx_ring.tail = rx_ring.head;
+    spin_unlock_irqrestore(&uart_lock, flags);
+}
+
+// Internal loopback: everything sent comes back as input (benchmarks)
+void uart_set_loopback(int on) {
+    unsigned int flags = spin_lock_irqsave(&uart_lock);
+    unsigned int cr = get32(UART0_CR);
+
+    put32(UART0_CR, on ? cr | CR_LBE : cr & ~CR_LBE);
+    spin_unlock_irqrestore(&uart_lock, flags);
+}
+
+// Queue a string, one uart_write per line so the FIFO is kicked per batch
 void uart_puts(const char *s) {
-    while (*s) {
-        if (*s == '\n') uart_send('\r');
-        uart_send(*s++);
+    const char *run = s;
+
+    for (; *s; s++) {
+        if (*s == '\n') {
+            uart_write(run, s - run);
+            uart_write("\r\n", 2);
+            run = s + 1;
+        }
     }
+    uart_write(run, s - run);
 }
@@ -0,0 +1,161 @@
+#include "mm.h"
+#include "spinlock.h"
+
+// One bit per 4 KB frame of RAM below RAM_END; a set bit means in use
+#define NR_FRAMES       (RAM_END >> PAGE_SHIFT)
+#define BITMAP_WORDS    (NR_FRAMES / 32)
+
+static unsigned int frame_bitmap[BITMAP_WORDS];
+static unsigned char frame_refs[NR_FRAMES];     // Mappings of each frame in use
+static unsigned char frame_tags[NR_FRAMES];     // Owner's note, see page_set_tag
+static unsigned int next_word;      // Next-fit hint: words below are likely full
+static unsigned int nr_free;
+static spinlock_t frame_lock = SPINLOCK_INIT;
+
+// Hand [start, end) to the allocator; everything else stays reserved
+void page_alloc_init(unsigned int start, unsigned int end) {
+    unsigned int first = PAGE_ALIGN(start) >> PAGE_SHIFT;
+    unsigned int last = (end > RAM_END ? RAM_END : end) >> PAGE_SHIFT;
+
+    for (unsigned int i = 0; i < BITMAP_WORDS; i++)
+        frame_bitmap[i] = 0xFFFFFFFF;
+    for (unsigned int pfn = first; pfn < last; pfn++)
+        frame_bitmap[pfn / 32] &= ~(1u << (pfn % 32));
+
+    next_word = first / 32;
+    nr_free = last > first ? last - first : 0;
+}
+
+// Returns the physical address of a zeroed frame, or 0 when RAM is exhausted
+unsigned int alloc_page(void) {
+    unsigned int flags = spin_lock_irqsave(&frame_lock);
+
+    for (unsigned int n = 0; n < BITMAP_WORDS; n++) {
+        unsigned int w = next_word + n;
+        if (w >= BITMAP_WORDS)
+            w -= BITMAP_WORDS;
+        if (frame_bitmap[w] == 0xFFFFFFFF)
+            continue;
+
+        unsigned int bit = __builtin_ctz(~frame_bitmap[w]);
+        frame_bitmap[w] |= 1u << bit;
+        frame_refs[w * 32 + bit] = 1;
+        next_word = w;
+        nr_free--;
+        spin_unlock_irqrestore(&frame_lock, flags);
+
+        unsigned int pa = (w * 32 + bit) << PAGE_SHIFT;
+        memzero(pa, PAGE_SIZE);
+        return pa;
+    }
+    spin_unlock_irqrestore(&frame_lock, flags);
+    return 0;
+}
+
+// Claim the n frames from pfn on; the caller holds frame_lock and has
+// checked they are free
+static unsigned int claim_run(unsigned int pfn, unsigned int n) {
+    for (unsigned int i = pfn; i < pfn + n; i++) {
+        frame_bitmap[i / 32] |= 1u << (i % 32);
+        frame_refs[i] = 1;
+    }
+    nr_free -= n;
+    return pfn << PAGE_SHIFT;
+}
+
+// 2^order contiguous zeroed frames, aligned to their size; 0 when no such
+// run is free. Runs up to 32 frames sit inside one bitmap word, longer ones
+// take whole free words.
+unsigned int alloc_pages(unsigned int order) {
+    unsigned int n = 1u << order;
+    unsigned int mask = n >= 32 ? 0xFFFFFFFF : (1u << n) - 1;
+    unsigned int words = n >= 32 ? n / 32 : 1;
+    unsigned int flags = spin_lock_irqsave(&frame_lock);
+    unsigned int pa = 0;
+
+    for (unsigned int w = next_word & ~(words - 1); !pa && w + words <= BITMAP_WORDS; w += words) {
+        if (words > 1) {
+            unsigned int i = 0;
+            while (i < words && !frame_bitmap[w + i])
+                i++;
+            if (i == words)
+                pa = claim_run(w * 32, n);
+            continue;
+        }
+        if (frame_bitmap[w] == 0xFFFFFFFF)
+            continue;
+        for (unsigned int bit = 0; bit < 32; bit += n) {
+            if (!(frame_bitmap[w] & (mask << bit))) {
+                pa = claim_run(w * 32 + bit, n);
+                break;
+            }
+        }
+    }
+    spin_unlock_irqrestore(&frame_lock, flags);
+
+    if (pa)
+        memzero(pa, n << PAGE_SHIFT);
+    return pa;
+}
+
+void free_pages(unsigned int pa, unsigned int order) {
+    for (unsigned int i = 0; i < (1u << order); i++)
+        free_page(pa + (i << PAGE_SHIFT));
+}
+
+void free_page(unsigned int pa) {
+    unsigned int pfn = pa >> PAGE_SHIFT;
+    unsigned int flags;
+
+    if (pfn >= NR_FRAMES)
+        return;
+
+    flags = spin_lock_irqsave(&frame_lock);
+    if (frame_bitmap[pfn / 32] & (1u << (pfn % 32))) {
+        frame_bitmap[pfn / 32] &= ~(1u << (pfn % 32));
+        frame_refs[pfn] = 0;
+        frame_tags[pfn] = 0;
+        if (pfn / 32 < next_word)
+            next_word = pfn / 32;
+        nr_free++;
+    }
+    spin_unlock_irqrestore(&frame_lock, flags);
+}
+
+// Reference counts for frames mapped by several address spaces (fork shares
+// them copy-on-write). alloc_page() hands out a frame with one reference.
+void page_get(unsigned int pa) {
+    unsigned int flags = spin_lock_irqsave(&frame_lock);
+
+    frame_refs[pa >> PAGE_SHIFT]++;
+    spin_unlock_irqrestore(&frame_lock, flags);
+}
+
+// Drop a reference; the last one frees the frame
+void page_put(unsigned int pa) {
+    unsigned int flags = spin_lock_irqsave(&frame_lock);
+    unsigned int last = --frame_refs[pa >> PAGE_SHIFT] == 0;
+
+    spin_unlock_irqrestore(&frame_lock, flags);
+    if (last)
+        free_page(pa);
+}
+
+unsigned int page_refs(unsigned int pa) {
+    return frame_refs[pa >> PAGE_SHIFT];
+}
+
+// One byte per frame for allocators built on this one (kmalloc), so they
+// can tell from an address alone what they handed out there. Cleared when
+// the frame is freed.
+void page_set_tag(unsigned int pa, unsigned int tag) {
+    frame_tags[pa >> PAGE_SHIFT] = tag;
+}
+
+unsigned int page_tag(unsigned int pa) {
+    return frame_tags[pa >> PAGE_SHIFT];
+}
+
+unsigned int pages_free(void) {
+    return nr_free;
+}
@@ -0,0 +1,613 @@
+#include "sched.h"
+#include "smp.h"
+#include "spinlock.h"
+#include "mm.h"
+#include "translation.h"
+#include "timer.h"
+#include "irq.h"
+#include "pmu.h"
+#include "trace.h"
+#include "asid.h"
+#include "fault.h"
+#include "syscall.h"
+#include "kmalloc.h"
+#include "exec.h"
+
+#define PSR_MODE_USR    0x10
+
+/*
+ * One run queue per core, holding the runnable tasks other than the one on
+ * the core. Each core's boot context is its idle task and runs only when
+ * the queue is empty and nothing can be stolen; core 0's keeps running
+ * kernel_main (and the benchmarks) as an ordinary pinned task until it
+ * idles too.
+ */
+struct runqueue {
+    ticket_lock_t lock;
+    struct task *head, *tail;
+    volatile unsigned int nr_queued;
+    struct task idle;
+    struct task *prev;              // Just switched out, see schedule_tail
+    unsigned int switch_start;
+    volatile int need_resched;
+    struct timer slice;             // Pending only while a task runs
+};
+
+static struct task *tasks[NR_TASKS];      // By pid; kmalloc'd, 0 when free
+static struct runqueue runqueues[NR_CPUS];
+static spinlock_t tasks_lock = SPINLOCK_INIT;
+static unsigned int slice_ticks;
+static volatile unsigned int active_mask = 1;
+
+struct task *cpu_curr[NR_CPUS];
+struct sched_stats sched_stats[NR_CPUS];
+
+static struct runqueue *this_rq(void) {
+    return &runqueues[smp_processor_id()];
+}
+
+// Run queue helpers; the caller holds rq->lock
+static void enqueue(struct runqueue *rq, struct task *t) {
+    t->next = 0;
+    if (rq->tail)
+        rq->tail->next = t;
+    else
+        rq->head = t;
+    rq->tail = t;
+    t->cpu = rq - runqueues;
+    t->queued = 1;
+    rq->nr_queued++;
+}
+
+// prev is the entry before t, or 0 when t is the head
+static void rq_unlink(struct runqueue *rq, struct task *prev, struct task *t) {
+    if (prev)
+        prev->next = t->next;
+    else
+        rq->head = t->next;
+    if (rq->tail == t)
+        rq->tail = prev;
+    t->next = 0;
+    t->queued = 0;
+    rq->nr_queued--;
+}
+
+static struct task *dequeue(struct runqueue *rq) {
+    struct task *t = rq->head;
+
+    if (t)
+        rq_unlink(rq, 0, t);
+    return t;
+}
+
+static void rq_remove(struct runqueue *rq, struct task *t) {
+    struct task *prev = 0;
+
+    for (struct task *p = rq->head; p; prev = p, p = p->next) {
+        if (p == t) {
+            rq_unlink(rq, prev, t);
+            return;
+        }
+    }
+}
+
+// Work stealing: a core with nothing queued takes the first movable task
+// from the longest queue of the other active cores. A task still on_cpu
+// was queued by a core that has not finished switching away from it yet.
+static struct task *steal(unsigned int cpu) {
+    struct runqueue *victim = 0;
+    struct task *t, *prev = 0;
+
+    if (!(active_mask & (1 << cpu)))
+        return 0;
+
+    for (unsigned int i = 0; i < NR_CPUS; i++) {
+        if (i == cpu || !(active_mask & (1 << i)) || !runqueues[i].nr_queued)
+            continue;
+        if (!victim || runqueues[i].nr_queued > victim->nr_queued)
+            victim = &runqueues[i];
+    }
+    if (!victim)
+        return 0;
+
+    ticket_lock(&victim->lock);
+    for (t = victim->head; t; prev = t, t = t->next) {
+        if (!t->pinned && !t->on_cpu) {
+            rq_unlink(victim, prev, t);
+            break;
+        }
+    }
+    ticket_unlock(&victim->lock);
+    return t;
+}
+
+// Wake idle cores so they can steal work that was just queued
+static void kick_idle_cores(void) {
+    unsigned int self = smp_processor_id();
+
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++) {
+        if (cpu != self && (active_mask & (1 << cpu)) &&
+            cpu_curr[cpu] == &runqueues[cpu].idle)
+            smp_send_reschedule(cpu);
+    }
+}
+
+// The running task's slice ran out: reschedule on IRQ exit
+static void slice_expired(struct timer *t) {
+    sched_stats[smp_processor_id()].ticks++;
+    this_rq()->need_resched = 1;
+}
+
+// Tickless: a core running a task has its slice timer pending, an idle
+// core has none and sleeps until its next timer or an IPI
+static void slice_start(struct runqueue *rq, struct task *next) {
+    if (next->state == TASK_IDLE) {
+        timer_del(&rq->slice);
+    } else {
+        rq->slice.expires = timer_count() + slice_ticks;
+        timer_add(&rq->slice);
+    }
+}
+
+void sched_set_slice(unsigned int slice_us) {
+    unsigned int flags = irq_save();
+
+    slice_ticks = timer_us_to_ticks(slice_us);
+    slice_start(this_rq(), current);
+    irq_restore(flags);
+}
+
+// Cores outside mask stop stealing and are not sent new work; they still
+// run whatever is already on their own queue
+void sched_set_active(unsigned int mask) {
+    active_mask = (mask & cpu_online_mask) | 1;
+}
+
+void sched_init(unsigned int slice_us) {
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++) {
+        struct task *idle = &runqueues[cpu].idle;
+
+        idle->state = TASK_IDLE;
+        idle->pinned = 1;
+        idle->on_cpu = 1;
+        idle->cpu = cpu;
+        idle->timer.cpu = -1;
+        cpu_curr[cpu] = idle;
+        runqueues[cpu].slice = (struct timer)TIMER_INIT(slice_expired);
+    }
+    runqueues[0].idle.state = TASK_RUNNING;
+
+    timer_init();
+    sched_set_slice(slice_us);
+}
+
+// Cores 1-3 start idle, so no slice timer until they pick up a task
+void sched_init_secondary(void) {
+    timer_init();
+}
+
+static void sleep_timeout(struct timer *tm);
+
+// Claim a free pid with a zeroed task, a kernel stack and an empty address
+// space; the caller holds tasks_lock and fills in the context
+static struct task *task_alloc(void) {
+    struct task *t;
+    unsigned int kstack;
+    unsigned int *pgd;
+    int pid;
+
+    for (pid = 1; pid < NR_TASKS && tasks[pid]; pid++);
+    if (pid == NR_TASKS)
+        return 0;
+
+    t = kzalloc(sizeof(*t));
+    kstack = alloc_page();
+    pgd = pgd_alloc();
+    if (!t || !kstack || !pgd) {
+        kfree(t);
+        if (kstack)
+            free_page(kstack);
+        if (pgd)
+            pgd_free(pgd);
+        return 0;
+    }
+
+    t->pid = pid;
+    t->kstack = kstack;
+    t->pgd = pgd;
+    t->timer = (struct timer)TIMER_INIT(sleep_timeout);
+    tasks[pid] = t;
+    return t;
+}
+
+// Undo task_alloc; the caller holds tasks_lock
+static void task_free(struct task *t) {
+    tasks[t->pid] = 0;
+    free_page(t->kstack);
+    pgd_free(t->pgd);
+    kfree(t);
+}
+
+// Queue a new task here; idle cores steal it if this one is busy
+static void task_start(struct task *t) {
+    unsigned int flags = irq_save();
+    struct runqueue *rq = this_rq();
+
+    ticket_lock(&rq->lock);
+    enqueue(rq, t);
+    ticket_unlock(&rq->lock);
+    kick_idle_cores();
+    irq_restore(flags);
+}
+
+// Every process has its own address space, so all stacks sit at the same
+// address; the first push faults in a zeroed page (fault.c)
+static int task_create_at(unsigned int entry, const struct user_image *img) {
+    unsigned int flags = spin_lock_irqsave(&tasks_lock);
+    struct task *t = task_alloc();
+
+    if (!t) {
+        spin_unlock_irqrestore(&tasks_lock, flags);
+        return -1;
+    }
+    t->ctx.r4 = entry;
+    t->image = img;
+    t->exec_ticks = timer_count();
+    t->ctx.sp = t->kstack + PAGE_SIZE;
+    t->ctx.lr = (unsigned int)ret_from_fork;
+    t->ctx.spsr = PSR_MODE_USR;
+    t->ctx.sp_usr = USER_STACK_TOP;
+    t->state = TASK_RUNNING;
+    spin_unlock_irqrestore(&tasks_lock, flags);
+
+    task_start(t);
+    return t->pid;
+}
+
+int task_create(void (*entry)(void)) {
+    return task_create_at((unsigned int)entry, 0);
+}
+
+// New process running an initramfs program; nothing of it is mapped until
+// its first instruction fetch faults. img may be a failed image_lookup
+int task_exec(const struct user_image *img) {
+    if (!img)
+        return -1;
+    return task_create_at(img->entry, img);
+}
+
+/*
+ * fork(): the child gets the caller's private pages copy-on-write, so the
+ * cost grows with the pages touched so far, not with the windows' size.
+ * It resumes from a copy of the caller's syscall frame f with r0 = 0,
+ * in the User-mode state the caller trapped from.
+ */
+int task_fork(struct svc_frame *f) {
+    struct fault_stats *st = &fault_stats[smp_processor_id()];
+    unsigned int c0 = pmu_cycles();
+    unsigned int flags = spin_lock_irqsave(&tasks_lock);
+    struct task *t = task_alloc();
+    struct svc_frame *cf;
+    int shared = -1;
+
+    if (t)
+        shared = pgd_copy_cow(t->pgd, current->pgd);
+    if (shared < 0) {
+        if (t)
+            task_free(t);
+        spin_unlock_irqrestore(&tasks_lock, flags);
+        return -1;
+    }
+    flush_tlb_asid();       // The caller's private pages just became read-only
+
+    t->image = current->image;
+    cf = (struct svc_frame *)(t->kstack + PAGE_SIZE) - 1;
+    *cf = *f;
+    cf->r[0] = 0;
+    t->ctx.sp = (unsigned int)cf;
+    t->ctx.lr = (unsigned int)ret_from_fork_frame;
+    asm volatile("mrs %0, spsr" : "=r"(t->ctx.spsr));
+    asm volatile("stmia %0, {sp, lr}^" :: "r"(&t->ctx.sp_usr) : "memory");
+    t->state = TASK_RUNNING;
+    spin_unlock_irqrestore(&tasks_lock, flags);
+
+    st->forks++;
+    st->fork_pages += shared;
+    st->fork_cycles += pmu_cycles() - c0;
+    task_start(t);
+    return t->pid;
+}
+
+/*
+ * Sleep until wake_up(wq). The caller holds lock with IRQs masked and has
+ * just found its condition false; the lock is dropped only once the task
+ * is on the queue, so a wake_up from the other side cannot be missed.
+ * Returns with the lock held again; the caller re-checks its condition.
+ * Only tasks may sleep, never a core's boot context.
+ */
+void sleep_on(struct wait_queue *wq, spinlock_t *lock) {
+    sleep_on_timeout(wq, lock, 0);
+}
+
+/*
+ * As sleep_on, but also woken once timer_count() reaches deadline (0 for
+ * never). wq and lock may be 0 for a plain timed sleep. The timer is armed
+ * on this core, which cannot take it before schedule() switches away.
+ */
+void sleep_on_timeout(struct wait_queue *wq, spinlock_t *lock, unsigned long long deadline) {
+    struct task *t = current;
+
+    if (wq) {
+        spin_lock(&wq->lock);
+        t->wq = wq;
+        t->wq_next = wq->head;
+        wq->head = t;
+    }
+    t->state = TASK_SLEEPING;
+    if (wq)
+        spin_unlock(&wq->lock);
+    if (deadline) {
+        t->timer.expires = deadline;
+        timer_add(&t->timer);
+    }
+
+    if (lock)
+        spin_unlock(lock);
+    schedule();
+    if (deadline)
+        timer_del(&t->timer);
+    if (lock)
+        spin_lock(lock);
+}
+
+/*
+ * Make t runnable on the core it slept on. That core may still be
+ * switching away from it, which is why the sleeper's schedule() skips
+ * enqueueing a task that is already queued; nothing else takes a task
+ * that is still on_cpu.
+ */
+static void task_wake(struct task *t) {
+    struct runqueue *rq = &runqueues[t->cpu];
+    int woken = 0;
+
+    ticket_lock(&rq->lock);
+    if (t->state == TASK_SLEEPING) {
+        t->state = TASK_RUNNING;
+        if (!t->queued)
+            enqueue(rq, t);
+        woken = 1;
+    }
+    ticket_unlock(&rq->lock);
+
+    if (!woken)
+        return;
+    if (rq == this_rq())
+        rq->need_resched = 1;
+    else
+        smp_send_reschedule(t->cpu);
+}
+
+// Wake every sleeper on wq and return how many; IRQs must be masked
+int wake_up(struct wait_queue *wq) {
+    struct task *t;
+    int n = 0;
+
+    spin_lock(&wq->lock);
+    while ((t = wq->head)) {
+        wq->head = t->wq_next;
+        t->wq = 0;
+        task_wake(t);
+        n++;
+    }
+    spin_unlock(&wq->lock);
+    return n;
+}
+
+// Take a sleeping task off its wait queue, when killed or timed out
+static void wait_remove(struct task *t) {
+    unsigned int flags = irq_save();
+    struct wait_queue *wq = t->wq;
+
+    if (wq) {
+        spin_lock(&wq->lock);
+        for (struct task **p = &wq->head; *p; p = &(*p)->wq_next) {
+            if (*p == t) {
+                *p = t->wq_next;
+                break;
+            }
+        }
+        t->wq = 0;
+        spin_unlock(&wq->lock);
+    }
+    irq_restore(flags);
+}
+
+static void sleep_timeout(struct timer *tm) {
+    struct task *t = (struct task *)((char *)tm - __builtin_offsetof(struct task, timer));
+
+    wait_remove(t);
+    task_wake(t);
+}
+
+// Tear down a task other than the caller. Once it is off every run queue
+// and no core holds its registers, its kernel stack only has the frames of
+// where it was switched out and can simply be dropped.
+void task_kill(int pid) {
+    struct task *t;
+    unsigned int flags;
+    int done;
+
+    if (pid <= 0 || pid >= NR_TASKS || !(t = tasks[pid]) || t == current)
+        return;
+
+    t->state = TASK_ZOMBIE;     // Never queued again
+    wait_remove(t);
+    timer_del_sync(&t->timer);  // sleep_timeout may still be using t
+    do {
+        struct runqueue *rq;
+
+        flags = irq_save();
+        rq = &runqueues[t->cpu];
+        ticket_lock(&rq->lock);
+        if (t->queued && t->cpu == (unsigned int)(rq - runqueues))
+            rq_remove(rq, t);
+        done = !t->queued && !t->on_cpu;
+        ticket_unlock(&rq->lock);
+        irq_restore(flags);
+    } while (!done);
+
+    flags = spin_lock_irqsave(&tasks_lock);
+    task_free(t);
+    spin_unlock_irqrestore(&tasks_lock, flags);
+}
+
+int task_state(int pid) {
+    if (pid < 0 || pid >= NR_TASKS || !tasks[pid])
+        return TASK_UNUSED;
+    return tasks[pid]->state;
+}
+
+// What a zombie passed to exit, until task_kill reaps it
+int task_exit_code(int pid) {
+    if (pid < 0 || pid >= NR_TASKS || !tasks[pid])
+        return 0;
+    return tasks[pid]->exit_code;
+}
+
+// When pid was created or last called execve()
+unsigned long long task_exec_ticks(int pid) {
+    if (pid < 0 || pid >= NR_TASKS || !tasks[pid])
+        return 0;
+    return tasks[pid]->exec_ticks;
+}
+
+// Round-robin within the core: requeue prev at the tail and take the head,
+// else steal, else idle
+void schedule(void) {
+    unsigned int flags = irq_save();
+    unsigned int cpu = smp_processor_id();
+    unsigned int c0 = pmu_cycles();
+    struct runqueue *rq = &runqueues[cpu];
+    struct sched_stats *stats = &sched_stats[cpu];
+    struct task *prev = cpu_curr[cpu];
+    struct task *next;
+
+    rq->need_resched = 0;
+    ticket_lock(&rq->lock);
+    if (prev->state == TASK_RUNNING && !prev->queued)   // Queued: woken early
+        enqueue(rq, prev);
+    next = dequeue(rq);
+    ticket_unlock(&rq->lock);
+
+    if (!next && (next = steal(cpu)))
+        stats->steals++;
+    if (!next)
+        next = &rq->idle;
+
+    stats->schedules++;
+    stats->pick_cycles += pmu_cycles() - c0;
+
+    slice_start(rq, next);
+    if (next != prev) {
+        stats->switches++;
+        trace_event(TRACE_SWITCH, next->pid);
+        next->on_cpu = 1;
+        next->cpu = cpu;
+        cpu_curr[cpu] = next;
+        rq->prev = prev;
+        rq->switch_start = pmu_cycles();
+        switch_mm(next);
+        cpu_switch_to(&prev->ctx, &next->ctx);
+        // Back in prev, possibly on another core
+        schedule_tail();
+    }
+    irq_restore(flags);
+}
+
+// First thing a task runs after being switched in (ret_from_fork calls it
+// for new tasks): the previous task's registers are saved now, so another
+// core may pick it up
+void schedule_tail(void) {
+    unsigned int cpu = smp_processor_id();
+    struct runqueue *rq = &runqueues[cpu];
+
+    sched_stats[cpu].switch_cycles += pmu_cycles() - rq->switch_start;
+    dmb();
+    rq->prev->on_cpu = 0;
+}
+
+// Reschedule IPI from another core
+void sched_ipi(void) {
+    this_rq()->need_resched = 1;
+}
+
+// Called by irq_handler before returning to User mode only: kernel paths
+// such as uart_write are not reentrant, so EL1 code is never preempted
+void sched_preempt(void) {
+    if (this_rq()->need_resched)
+        schedule();
+}
+
+// WFI with IRQs masked, counted as idle residency. It wakes on a pending
+// IRQ even with CPSR.I set, which the caller then lets in.
+static void idle_wait(void) {
+    struct sched_stats *st = &sched_stats[smp_processor_id()];
+    unsigned long long t0 = timer_count();
+
+    asm volatile("wfi");
+    st->idle_ticks += timer_count() - t0;
+    st->wakeups++;
+}
+
+// The boot context becomes the idle task: sleep until an interrupt asks for
+// a reschedule, and yield to anything that is runnable. With no slice timer
+// pending, only a task's sleep timeout or an IRQ ends the WFI.
+void sched_idle(void) {
+    struct runqueue *rq = this_rq();
+
+    rq->idle.state = TASK_IDLE;
+    while (1) {
+        schedule();
+        disable_irq();
+        if (!rq->need_resched)
+            idle_wait();
+        enable_irq();
+    }
+}
+
+static void boot_sleep_done(struct timer *t) {
+}
+
+/*
+ * Wait for us microseconds. Up to UDELAY_MAX_US spins on the counter.
+ * Longer waits sleep: a task on its timer, while other tasks run. A core's
+ * boot context (kernel_main, the benchmarks) cannot be switched away from,
+ * so it waits in WFI and only lets interrupts in.
+ */
+void sleep_us(unsigned int us) {
+    unsigned long long deadline = timer_count() + timer_us_to_ticks(us);
+    unsigned int flags;
+
+    if (us <= UDELAY_MAX_US) {
+        udelay(us);
+        return;
+    }
+
+    flags = irq_save();
+    if (current == &this_rq()->idle) {
+        struct timer t = TIMER_INIT(boot_sleep_done);
+
+        t.expires = deadline;
+        timer_add(&t);
+        while (timer_count() < deadline) {
+            idle_wait();
+            enable_irq();
+            disable_irq();
+        }
+        timer_del(&t);
+    } else {
+        while (timer_count() < deadline)
+            sleep_on_timeout(0, 0, deadline);
+    }
+    irq_restore(flags);
+}
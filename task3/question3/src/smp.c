@@ -0,0 +1,68 @@
+#include "smp.h"
+#include "sched.h"
+#include "irq.h"
+#include "pmu.h"
+#include "timer.h"
+#include "utils.h"
+#include "barrier.h"
+#include "printf.h"
+#include "peripherals/irq.h"
+
+#define SMP_BOOT_TIMEOUT_US     100000
+
+// secondary_start in boot.S: stacks, MMU and caches, then secondary_main
+extern void secondary_start(void);
+
+volatile unsigned int cpu_online_mask = 1;
+
+static void ipi_init(unsigned int cpu) {
+    put32(CORE_MBOX_CLR(cpu, 0), 0xFFFFFFFF);
+    put32(CORE_MBOX_IRQCNTL(cpu), LOCAL_MBOX0_IRQ);
+}
+
+// Core 0: release cores 1-3 by writing secondary_start to their mailbox 3,
+// where the firmware (or QEMU's boot stub, or _start) waits for it
+void smp_init(void) {
+    ipi_init(0);
+
+    for (unsigned int cpu = 1; cpu < NR_CPUS; cpu++) {
+        unsigned long long t0 = timer_count();
+        unsigned long long timeout = timer_us_to_ticks(SMP_BOOT_TIMEOUT_US);
+
+        put32(CORE_MBOX_SET(cpu, 3), (unsigned int)secondary_start);
+        dsb();
+        asm volatile("sev");
+
+        while (!(cpu_online_mask & (1 << cpu)) && timer_count() - t0 < timeout);
+        if (!(cpu_online_mask & (1 << cpu)))
+            printf("smp: core %u did not start\n", cpu);
+    }
+    sched_set_active(cpu_online_mask);
+}
+
+// Cores 1-3 arrive here with the MMU and caches already on
+void secondary_main(unsigned int cpu) {
+    pmu_init();
+    ipi_init(cpu);
+    sched_init_secondary();
+
+    dmb();
+    cpu_online_mask |= 1 << cpu;   // smp_init starts cores one at a time
+    dsb();
+    asm volatile("sev");
+
+    enable_irq();
+    sched_idle();
+}
+
+// Ask another core to run schedule(): it may have been idle with work queued
+void smp_send_reschedule(unsigned int cpu) {
+    put32(CORE_MBOX_SET(cpu, 0), 1);
+}
+
+void smp_handle_ipi(void) {
+    unsigned int cpu = smp_processor_id();
+
+    put32(CORE_MBOX_CLR(cpu, 0), 0xFFFFFFFF);
+    sched_ipi();
+}
@@ -1,6 +1,249 @@
 #include "printf.h"
-void handle_syscall(unsigned int syscall_num) {
-    if (syscall_num == 0) {
-        printf("Hello from EL0 via syscall!\n");
+#include "mini_uart.h"
+#include "syscall.h"
+#include "translation.h"
+#include "sched.h"
+#include "trace.h"
+#include "timer.h"
+#include "exec.h"
+#include "mm.h"
+#include "ipc.h"
+#include "string.h"
+
+static int sys_null(unsigned int a0, unsigned int a1, unsigned int a2, struct svc_frame *f) {
+    return 0;
+}
+
+// The task stops running here; whoever created it reaps it with task_kill
+static int sys_exit(unsigned int status, unsigned int a1, unsigned int a2, struct svc_frame *f) {
+    current->exit_code = status;
+    current->state = TASK_ZOMBIE;
+    schedule();
+    return 0;   // Not reached
+}
+
+// Full-save: the child resumes from a copy of the caller's frame
+static int sys_fork(unsigned int a0, unsigned int a1, unsigned int a2, struct svc_frame *f) {
+    int pid = task_fork(f);
+
+    return pid < 0 ? -EAGAIN : pid;
+}
+
+/*
+ * execve(path): replace the caller with the initramfs program path. Full
+ * save, so the return lands on the new entry point with clean registers.
+ * The name is copied out before the old mappings go.
+ */
+static int sys_execve(unsigned int upath, unsigned int a1, unsigned int a2, struct svc_frame *f) {
+    char name[INITRAMFS_NAME_MAX];
+    const struct user_image *img;
+    unsigned int i;
+
+    for (i = 0; i < INITRAMFS_NAME_MAX; i++) {
+        if ((i == 0 || ((upath + i) & (PAGE_SIZE - 1)) == 0) && !user_range_ok(upath + i, 1, 0))
+            return -EFAULT;
+        name[i] = ((const char *)upath)[i];
+        if (!name[i])
+            break;
     }
-}
\ No newline at end of file
+    if (i == INITRAMFS_NAME_MAX)
+        return -ENOENT;
+    img = image_lookup(name);
+    if (!img)
+        return -ENOENT;
+
+    current->exec_ticks = timer_count();
+    exec_image(f, img);
+    return 0;
+}
+
+static int sys_getpid(unsigned int a0, unsigned int a1, unsigned int a2, struct svc_frame *f) {
+    return current->pid;
+}
+
+// Give up the rest of the slice; returns once round-robin comes back here
+static int sys_sched_yield(unsigned int a0, unsigned int a1, unsigned int a2, struct svc_frame *f) {
+    schedule();
+    return 0;
+}
+
+// read(fd, buf, len): sleeps in the console driver until input is there
+static int sys_read(unsigned int fd, unsigned int buf, unsigned int len, struct svc_frame *f) {
+    if (fd != STDIN_FILENO)
+        return -EBADF;
+    if (!user_range_ok(buf, len, 1))
+        return -EFAULT;
+    if (!len)
+        return 0;
+
+    return uart_read((char *)buf, len);
+}
+
+static unsigned int poll_events(const struct pollfd *p) {
+    if (p->fd == STDIN_FILENO)
+        return p->events & POLLIN;
+    if (p->fd == STDOUT_FILENO || p->fd == STDERR_FILENO)
+        return p->events & POLLOUT;
+    return POLLNVAL;
+}
+
+/*
+ * poll(fds, nfds, timeout): the console is the only file. A non-zero
+ * timeout sleeps until something is ready, or until the deadline when it
+ * is positive.
+ */
+static int sys_poll(unsigned int ufds, unsigned int nfds, unsigned int timeout, struct svc_frame *f) {
+    struct pollfd *fds = (struct pollfd *)ufds;
+    unsigned long long deadline = timer_count() + (unsigned long long)timer_us_to_ticks(1000) * timeout;
+    unsigned int want = 0, ready;
+    int n, nval = 0;
+
+    if (nfds > POLL_MAX)
+        return -EINVAL;
+    if (!user_range_ok(ufds, nfds * sizeof(*fds), 1))
+        return -EFAULT;
+
+    for (unsigned int i = 0; i < nfds; i++) {
+        unsigned int ev = poll_events(&fds[i]);
+
+        if (ev == POLLNVAL)
+            nval = 1;
+        else
+            want |= ev;
+    }
+
+    while (1) {
+        ready = uart_poll(want, timeout && !nval, (int)timeout > 0 ? deadline : 0);
+        n = 0;
+        for (unsigned int i = 0; i < nfds; i++) {
+            unsigned int ev = poll_events(&fds[i]);
+
+            fds[i].revents = ev == POLLNVAL ? POLLNVAL : ev & ready;
+            if (fds[i].revents)
+                n++;
+        }
+        if (n || !timeout)
+            return n;
+        if ((int)timeout > 0 && timer_count() >= deadline)
+            return 0;
+    }
+}
+
+// write(fd, buf, len): copy straight from the user mapping into the TX queue
+static int sys_write(unsigned int fd, unsigned int buf, unsigned int len, struct svc_frame *f) {
+    if (fd != STDOUT_FILENO && fd != STDERR_FILENO)
+        return -EBADF;
+    if (!user_range_ok(buf, len, 0))
+        return -EFAULT;
+
+    uart_write((const char *)buf, len);
+    return len;
+}
+
+// writev(fd, iov, iovcnt): every buffer is validated before any is queued,
+// so a bad entry fails the whole call without partial output. The array is
+// copied in first: it may sit in a shared IPC page that another core can
+// rewrite between the check and the write
+static int sys_writev(unsigned int fd, unsigned int uiov, unsigned int iovcnt, struct svc_frame *f) {
+    struct iovec kiov[IOV_MAX];
+    unsigned int total = 0;
+
+    if (fd != STDOUT_FILENO && fd != STDERR_FILENO)
+        return -EBADF;
+    if (iovcnt > IOV_MAX)
+        return -EINVAL;
+    if (!user_range_ok(uiov, iovcnt * sizeof(kiov[0]), 0))
+        return -EFAULT;
+    memcpy(kiov, (const void *)uiov, iovcnt * sizeof(kiov[0]));
+
+    for (unsigned int i = 0; i < iovcnt; i++) {
+        if (!user_range_ok((unsigned int)kiov[i].iov_base, kiov[i].iov_len, 0))
+            return -EFAULT;
+        total += kiov[i].iov_len;
+    }
+
+    for (unsigned int i = 0; i < iovcnt; i++)
+        uart_write(kiov[i].iov_base, kiov[i].iov_len);
+    return total;
+}
+
+static int sys_chan_create(unsigned int a0, unsigned int a1, unsigned int a2, struct svc_frame *f) {
+    return ipc_create();
+}
+
+static int sys_chan_map(unsigned int id, unsigned int a1, unsigned int a2, struct svc_frame *f) {
+    return ipc_map(id);
+}
+
+static int sys_chan_send(unsigned int id, unsigned int buf, unsigned int len, struct svc_frame *f) {
+    if (!user_range_ok(buf, len, 0))
+        return -EFAULT;
+    return ipc_send(id, (const void *)buf, len);
+}
+
+static int sys_chan_recv(unsigned int id, unsigned int buf, unsigned int len, struct svc_frame *f) {
+    if (!user_range_ok(buf, len, 1))
+        return -EFAULT;
+    return ipc_recv(id, (void *)buf, len);
+}
+
+// futex(uaddr, op, val): only WAIT and WAKE; WAKE wakes every waiter
+// rather than val of them
+static int sys_futex(unsigned int uaddr, unsigned int op, unsigned int val, struct svc_frame *f) {
+    if (uaddr & 3)
+        return -EINVAL;
+    if (!user_range_ok(uaddr, 4, 0))
+        return -EFAULT;
+
+    switch (op) {
+    case FUTEX_WAIT:
+        return futex_wait(uaddr, val);
+    case FUTEX_WAKE:
+        return futex_wake(uaddr);
+    }
+    return -ENOSYS;
+}
+
+#ifdef TRACE
+// trace_ctl(cmd, arg): the dump runs in the caller's context, IRQs masked
+static int sys_trace_ctl(unsigned int cmd, unsigned int arg, unsigned int a2, struct svc_frame *f) {
+    switch (cmd) {
+    case TRACE_CTL_STOP:
+        trace_stop();
+        return 0;
+    case TRACE_CTL_START:
+        trace_start();
+        return 0;
+    case TRACE_CTL_DUMP:
+        trace_dump();
+        return 0;
+    case TRACE_CTL_MARK:
+        trace_event(TRACE_MARK, arg);
+        return 0;
+    }
+    return -EINVAL;
+}
+#endif
+
+// Indexed by r7 in svc_handler.S. Empty slots return -ENOSYS; entries
+// without SYSCALL_FULL_SAVE take the fast path that skips saving r4-r11
+const struct syscall_entry syscall_table[NR_SYSCALLS] = {
+    [SYS_NULL]        = { sys_null, 0 },
+    [SYS_EXIT]        = { sys_exit, 0 },
+    [SYS_FORK]        = { sys_fork, SYSCALL_FULL_SAVE },
+    [SYS_READ]        = { sys_read, 0 },
+    [SYS_WRITE]       = { sys_write, 0 },
+    [SYS_EXECVE]      = { sys_execve, SYSCALL_FULL_SAVE },
+    [SYS_GETPID]      = { sys_getpid, 0 },
+    [SYS_WRITEV]      = { sys_writev, 0 },
+    [SYS_SCHED_YIELD] = { sys_sched_yield, 0 },
+#ifdef TRACE
+    [SYS_TRACE_CTL]   = { sys_trace_ctl, 0 },
+#endif
+    [SYS_CHAN_CREATE] = { sys_chan_create, 0 },
+    [SYS_CHAN_MAP]    = { sys_chan_map, 0 },
+    [SYS_CHAN_SEND]   = { sys_chan_send, 0 },
+    [SYS_CHAN_RECV]   = { sys_chan_recv, 0 },
+    [SYS_POLL]        = { sys_poll, 0 },
+    [SYS_FUTEX]       = { sys_futex, 0 },
+};
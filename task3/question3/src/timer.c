@@ -0,0 +1,129 @@
+#include "timer.h"
+#include "utils.h"
+#include "smp.h"
+#include "irq.h"
+#include "spinlock.h"
+#include "peripherals/irq.h"
+
+// Pending timers per core. Only the owning core adds to its base, but any
+// core may cancel, hence the lock.
+struct timer_base {
+    spinlock_t lock;
+    struct timer *head;
+    struct timer * volatile running;    // Whose fn is running, see timer_del_sync
+};
+
+static struct timer_base bases[NR_CPUS];
+
+unsigned int timer_irqs[NR_CPUS];
+
+void timer_init(void) {
+    timer_disarm();
+    // CNTKCTL.PL0PCTEN: EL0 may read CNTPCT (user/crt0.S stamps its start)
+    asm volatile("mcr p15, 0, %0, c14, c1, 0" :: "r"(1));
+    // Route this core's virtual timer to IRQ (not FIQ)
+    put32(CORE_TIMER_IRQCNTL(smp_processor_id()), LOCAL_TIMER_CNTV_IRQ);
+}
+
+unsigned int timer_us_to_ticks(unsigned int us) {
+    return (unsigned int)udiv64((unsigned long long)us * timer_freq(), 1000000);
+}
+
+// Point CNTV at the earliest deadline; the caller holds the base lock. TVAL
+// is a signed 32-bit down-counter, so far deadlines take an extra interrupt.
+static void timer_program(struct timer_base *b) {
+    unsigned long long now = timer_count();
+    unsigned long long delta;
+
+    if (!b->head) {
+        timer_disarm();
+        return;
+    }
+    delta = b->head->expires > now ? b->head->expires - now : 1;
+    timer_arm(delta > 0x7FFFFFFF ? 0x7FFFFFFF : (unsigned int)delta);
+}
+
+// Queue t on this core; re-adding a pending timer moves it
+void timer_add(struct timer *t) {
+    unsigned int flags = irq_save();
+    struct timer_base *b = &bases[smp_processor_id()];
+    struct timer **p;
+
+    timer_del(t);
+    spin_lock(&b->lock);
+    for (p = &b->head; *p && (*p)->expires <= t->expires; p = &(*p)->next);
+    t->next = *p;
+    *p = t;
+    t->cpu = b - bases;
+    if (b->head == t)
+        timer_program(b);
+    spin_unlock(&b->lock);
+    irq_restore(flags);
+}
+
+// Cancel t if pending. Its core may take one interrupt for nothing.
+void timer_del(struct timer *t) {
+    unsigned int flags = irq_save();
+    int cpu = t->cpu;
+    struct timer_base *b;
+
+    if (cpu < 0) {
+        irq_restore(flags);
+        return;
+    }
+    b = &bases[cpu];
+    spin_lock(&b->lock);
+    if (t->cpu == cpu) {
+        for (struct timer **p = &b->head; *p; p = &(*p)->next) {
+            if (*p == t) {
+                *p = t->next;
+                break;
+            }
+        }
+        t->cpu = -1;
+    }
+    spin_unlock(&b->lock);
+    irq_restore(flags);
+}
+
+// timer_del, and also wait for t's fn if it is running on some core, so t
+// can be freed afterwards. Not for use from t's own fn.
+void timer_del_sync(struct timer *t) {
+    int busy;
+
+    do {
+        timer_del(t);
+        busy = 0;
+        for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++)
+            while (bases[cpu].running == t)
+                busy = 1;
+    } while (busy || t->cpu >= 0);     // fn may have added it again
+}
+
+// CNTV interrupt: run whatever has expired, then program the next deadline.
+// Handlers run without the lock so they may add timers themselves.
+void timer_handle_irq(void) {
+    struct timer_base *b = &bases[smp_processor_id()];
+    struct timer *t;
+
+    timer_irqs[b - bases]++;
+    spin_lock(&b->lock);
+    while ((t = b->head) && t->expires <= timer_count()) {
+        b->head = t->next;
+        t->cpu = -1;
+        b->running = t;
+        spin_unlock(&b->lock);
+        t->fn(t);
+        spin_lock(&b->lock);
+        b->running = 0;
+    }
+    timer_program(b);
+    spin_unlock(&b->lock);
+}
+
+// Busy-wait on the counter: short hardware settle times such as GPIO pulls
+void udelay(unsigned int us) {
+    unsigned long long end = timer_count() + timer_us_to_ticks(us);
+
+    while (timer_count() < end);
+}
@@ -0,0 +1,124 @@
+#ifdef TRACE
+
+#include "trace.h"
+#include "sched.h"
+#include "smp.h"
+#include "irq.h"
+#include "pmu.h"
+#include "timer.h"
+#include "barrier.h"
+#include "printf.h"
+#include "mini_uart.h"
+
+// Only the owning core writes a ring; head counts every record ever taken
+struct trace_ring {
+    struct trace_event ev[TRACE_RING_SIZE];
+    volatile unsigned int head;
+    volatile unsigned int busy;     // Inside trace_event, see trace_stop
+    unsigned int pmu[PMU_NR_EVENTS];    // Event counters at the last switch
+};
+
+static struct trace_ring rings[NR_CPUS];
+static volatile unsigned int trace_on;
+
+void trace_event(unsigned int type, unsigned int arg) {
+    unsigned int flags, cpu;
+    struct trace_ring *r;
+    struct trace_event *e;
+    struct task *t;
+
+    if (!trace_on)
+        return;
+
+    flags = irq_save();
+    cpu = smp_processor_id();
+    r = &rings[cpu];
+    // Claim the ring before the real test of trace_on, which pairs with
+    // trace_stop clearing it and then waiting for busy to drop
+    r->busy = 1;
+    dmb();
+    if (!trace_on) {
+        r->busy = 0;
+        irq_restore(flags);
+        return;
+    }
+    e = &r->ev[r->head & (TRACE_RING_SIZE - 1)];
+    e->cycles = pmu_cycles();
+    e->ts = (unsigned int)timer_count();
+    e->arg = arg;
+    e->type = type;
+    e->cpu = cpu;
+    t = cpu_curr[cpu];
+    e->pid = t ? t->pid : 0;
+    // The event counters are per core: sample them where it is cheap enough
+    if (type == TRACE_SWITCH)
+        for (unsigned int n = 0; n < PMU_NR_EVENTS; n++)
+            r->pmu[n] = pmu_event_read(n);
+    dmb();
+    r->head++;
+    r->busy = 0;
+    irq_restore(flags);
+}
+
+void trace_start(void) {
+    trace_on = 0;
+    dmb();
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++)
+        while (rings[cpu].busy);
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++)
+        rings[cpu].head = 0;
+    dmb();
+    trace_on = 1;
+}
+
+// Returns once no core is still writing a record
+void trace_stop(void) {
+    trace_on = 0;
+    dmb();
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++)
+        while (rings[cpu].busy);
+}
+
+// Binary dump of every ring (layout in trace.h), sent by DMA with the UART
+// claimed so no other core's output lands inside the frame
+void trace_dump(void) {
+    struct trace_header h = {
+        .magic = TRACE_MAGIC,
+        .version = TRACE_VERSION,
+        .ncpus = NR_CPUS,
+        .timer_hz = timer_freq(),
+        .event_size = sizeof(struct trace_event),
+        .pmu_events = PMU_EVENTS,
+    };
+    unsigned int end = TRACE_MAGIC_END;
+
+    trace_stop();
+    printf_flush();
+    uart_dma_begin();
+    uart_dma_write(&h, sizeof(h));
+
+    for (unsigned int cpu = 0; cpu < NR_CPUS; cpu++) {
+        struct trace_ring *r = &rings[cpu];
+        unsigned int head = r->head;
+        unsigned int count = head < TRACE_RING_SIZE ? head : TRACE_RING_SIZE;
+        unsigned int first = (head - count) & (TRACE_RING_SIZE - 1);
+        struct trace_cpu_header ch = { .cpu = cpu, .count = count, .lost = head - count };
+
+        for (unsigned int n = 0; n < PMU_NR_EVENTS; n++)
+            ch.pmu[n] = cpu == smp_processor_id() ? pmu_event_read(n) : r->pmu[n];
+
+        uart_dma_write(&ch, sizeof(ch));
+        // Oldest first: the tail of the array, then the wrapped part
+        if (first + count > TRACE_RING_SIZE) {
+            uart_dma_write(&r->ev[first], (TRACE_RING_SIZE - first) * sizeof(r->ev[0]));
+            uart_dma_write(&r->ev[0], (first + count - TRACE_RING_SIZE) * sizeof(r->ev[0]));
+        } else {
+            uart_dma_write(&r->ev[first], count * sizeof(r->ev[0]));
+        }
+    }
+
+    uart_dma_write(&end, sizeof(end));
+    uart_dma_end();
+}
+
+#endif /* TRACE */
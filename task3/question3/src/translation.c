@@ -1,29 +1,348 @@
 #include "translation.h"
+#include "mm.h"
+#include "barrier.h"
+#include "spinlock.h"
+#include "string.h"
+#include "fault.h"
+#include "kmalloc.h"
 #include "peripherals/base.h"
 
-#define SECTION_DESCRIPTOR        0x2
-#define REGION_DEVICE             0x00000010
-#define REGION_NORMAL             0x00001100
-#define AP_PRIV_RW_USER_NO        0x01
-#define AP_PRIV_RW_USER_RW        0x03
 #define PAGE_TABLE_ENTRIES        4096
 
-static unsigned int *ttb = (unsigned int *)TRANSLATION_TABLE_BASE;
+// Section ranges: RAM below the peripherals, the 16 MB BCM2835 peripheral
+// window and the 1 MB of BCM2836 ARM-local registers
+#define RAM_END_SECTION           (PERIPHERAL_BASE >> 20)
+#define PERIPHERAL_END_SECTION    ((PERIPHERAL_BASE + 0x01000000) >> 20)
+#define LOCAL_SECTION             (LOCAL_PERIPHERAL_BASE >> 20)
 
-void map_kernel_and_user_space() {
-    for (int i = 0; i < PAGE_TABLE_ENTRIES; i++) {
-        // Default mapping: privileged only
-        ttb[i] = (i << 20) | REGION_NORMAL | (AP_PRIV_RW_USER_NO << 10) | SECTION_DESCRIPTOR;
-    }
+// Page-aligned user program image, placed by linker.ld
+extern char user_begin[], user_end[];
+
+// Expand M(i) for n consecutive indices, so tables can be spelt out as
+// static initialisers instead of being filled in at boot
+#define REP4(M, i)      M(i), M((i) + 1), M((i) + 2), M((i) + 3)
+#define REP16(M, i)     REP4(M, i), REP4(M, (i) + 4), REP4(M, (i) + 8), REP4(M, (i) + 12)
+#define REP64(M, i)     REP16(M, i), REP16(M, (i) + 16), REP16(M, (i) + 32), REP16(M, (i) + 48)
+#define REP256(M, i)    REP64(M, i), REP64(M, (i) + 64), REP64(M, (i) + 128), REP64(M, (i) + 192)
+#define REP1024(M, i)   REP256(M, i), REP256(M, (i) + 256), REP256(M, (i) + 512), REP256(M, (i) + 768)
+#define REP4096(M, i)   REP1024(M, i), REP1024(M, (i) + 1024), REP1024(M, (i) + 2048), REP1024(M, (i) + 3072)
+
+#define L1_SECTION(i, attrs) \
+    (((unsigned int)(i) << 20) | (attrs) | (AP_PRIV_RW_USER_NO << 10) | SECTION_DESCRIPTOR)
+#define L1_SUPERSECTION(i, attrs) \
+    ((((unsigned int)(i) << 20) & SUPERSECTION_ADDR_MASK) | SUPERSECTION | (attrs) | \
+     (AP_PRIV_RW_USER_NO << 10) | SECTION_DESCRIPTOR)
+
+// Default first-level entry for MB i: privileged only; RAM cacheable, MMIO
+// device, everything else faults. RAM and the peripheral window are whole
+// 16 MB blocks, so they use supersections (one TLB entry per 16 MB),
+// except the first 16 MB, which holds MB 0's second-level table.
+#define L1_ENTRY(i) \
+    ((i) < SUPERSECTION_ENTRIES ? L1_SECTION(i, REGION_NORMAL) : \
+     (i) < RAM_END_SECTION ? L1_SUPERSECTION(i, REGION_NORMAL) : \
+     (i) < PERIPHERAL_END_SECTION ? L1_SUPERSECTION(i, REGION_DEVICE) : \
+     (i) == LOCAL_SECTION ? L1_SECTION(i, REGION_DEVICE) : 0)
+
+// Default entry for page i of the first MB: privileged-only RAM in 64 KB
+// large pages; map_user_image splits the ones the user image touches
+#define L2_KERNEL_PAGE(i) \
+    ((((unsigned int)(i) << PAGE_SHIFT) & ~(LARGE_PAGE_SIZE - 1)) | LARGE_PAGE_NORMAL | \
+     PAGE_AP(AP_PRIV_RW_USER_NO) | LARGE_PAGE)
+
+/*
+ * The first MB holds both the kernel and the user image, so it is mapped
+ * at page granularity. Both tables are complete in the kernel image
+ * (linker.ld .pgtable); map_user_image() only opens up the user pages.
+ */
+static unsigned int first_mb_l2[L2_ENTRIES]
+    __attribute__((section(".pgtable"), aligned(L2_TABLE_SIZE))) = {
+    REP256(L2_KERNEL_PAGE, 0)
+};
+
+unsigned int kernel_ttb[PAGE_TABLE_ENTRIES]
+    __attribute__((section(".pgtable"), aligned(L1_TABLE_ALIGN))) = {
+    REP4096(L1_ENTRY, 0),
+    [0] = (unsigned int)first_mb_l2 + COARSE_DESCRIPTOR,
+};
+
+static unsigned int *ttb = kernel_ttb;
 
-    // Map first 1 MB (code/data) as user-accessible
-    ttb[0x000] = (0x000 << 20) | REGION_NORMAL | (AP_PRIV_RW_USER_RW << 10) | SECTION_DESCRIPTOR;
+// Serialises second-level table allocation and PTE updates between cores
+static spinlock_t pgtable_lock = SPINLOCK_INIT;
 
-    // UART MMIO: privileged-only device memory
-    unsigned int uart_index = UART_BASE >> 20;
-    ttb[uart_index] = (uart_index << 20) | REGION_DEVICE | (AP_PRIV_RW_USER_NO << 10) | SECTION_DESCRIPTOR;
+// The only boot-time table work: make the user image reachable from EL0.
+// The 64 KB large pages it overlaps become small pages, the kernel's share
+// of them still privileged only. Runs before the MMU is on.
+void map_user_image(void) {
+    unsigned int begin = (unsigned int)user_begin, end = (unsigned int)user_end;
+    unsigned int pa = begin & ~(LARGE_PAGE_SIZE - 1);
+    unsigned int stop = (end + LARGE_PAGE_SIZE - 1) & ~(LARGE_PAGE_SIZE - 1);
+
+    for (; pa < stop; pa += PAGE_SIZE) {
+        unsigned int ap = pa >= begin && pa < end ? AP_PRIV_RW_USER_RW : AP_PRIV_RW_USER_NO;
+        first_mb_l2[pa >> PAGE_SHIFT] = pa | PAGE_NORMAL | PAGE_AP(ap) | SMALL_PAGE;
+    }
 }
 
 unsigned int *get_translation_table() {
     return ttb;
 }
+
+// Zeroed 1 KB second-level table, or 0 when out of memory. kmalloc aligns
+// objects to their size, which is what a coarse descriptor needs.
+static unsigned int alloc_l2_table(void) {
+    return (unsigned int)kzalloc(L2_TABLE_SIZE);
+}
+
+static void free_l2_table(unsigned int table) {
+    kfree((void *)table);
+}
+
+// New process address space: a first-level table holding the kernel's
+// global entries, copied from kernel_ttb. Later changes to kernel_ttb are
+// not propagated; the kernel mappings stay fixed once tasks exist.
+unsigned int *pgd_alloc(void) {
+    unsigned int *pgd = (unsigned int *)alloc_pages(L1_TABLE_ORDER);
+
+    if (pgd)
+        memcpy(pgd, kernel_ttb, sizeof(kernel_ttb));
+    return pgd;
+}
+
+// The second-level table of entry i if the process added it, else 0
+static unsigned int *private_l2(unsigned int *pgd, unsigned int i) {
+    if (pgd[i] == kernel_ttb[i] || (pgd[i] & 3) != COARSE_DESCRIPTOR)
+        return 0;
+    return (unsigned int *)(pgd[i] & COARSE_ADDR_MASK);
+}
+
+// Drop everything the process mapped, back to the kernel's entries only
+// (execve); the caller flushes its TLB entries
+void pgd_clear(unsigned int *pgd) {
+    unsigned int flags = spin_lock_irqsave(&pgtable_lock);
+
+    for (unsigned int i = 0; i < PAGE_TABLE_ENTRIES; i++) {
+        unsigned int *l2 = private_l2(pgd, i);
+        if (!l2)
+            continue;
+        for (unsigned int j = 0; j < L2_ENTRIES; j++)
+            if (l2[j] & SMALL_PAGE)
+                page_put(l2[j] & ~(PAGE_SIZE - 1));
+        pgd[i] = kernel_ttb[i];
+        free_l2_table((unsigned int)l2);
+    }
+    dsb();
+    spin_unlock_irqrestore(&pgtable_lock, flags);
+}
+
+// Drop a process's table, the second-level tables it added to the kernel's
+// and its reference on every page those map
+void pgd_free(unsigned int *pgd) {
+    pgd_clear(pgd);
+    free_pages((unsigned int)pgd, L1_TABLE_ORDER);
+}
+
+// fork: give dst every private page of src, both read-only from EL0 so the
+// first write by either side faults and copies (fault.c); IPC channel
+// pages stay writable and shared. Returns the number of pages shared, or
+// -1 if a second-level table could not be had. The caller flushes src's
+// TLB entries.
+int pgd_copy_cow(unsigned int *dst, unsigned int *src) {
+    unsigned int flags = spin_lock_irqsave(&pgtable_lock);
+    int shared = 0;
+
+    for (unsigned int i = 0; i < PAGE_TABLE_ENTRIES; i++) {
+        unsigned int *l2 = private_l2(src, i);
+        unsigned int table;
+
+        if (!l2)
+            continue;
+        table = alloc_l2_table();
+        if (!table) {
+            spin_unlock_irqrestore(&pgtable_lock, flags);
+            return -1;
+        }
+        for (unsigned int j = 0; j < L2_ENTRIES; j++) {
+            unsigned int va = (i << 20) | (j << PAGE_SHIFT);
+
+            if (!(l2[j] & SMALL_PAGE))
+                continue;
+            if (((l2[j] >> 4) & 3) == AP_PRIV_RW_USER_RW &&
+                (va < USER_IPC_BASE || va >= USER_IPC_BASE + USER_IPC_SIZE))
+                l2[j] = (l2[j] & ~PAGE_AP(3)) | PAGE_AP(AP_PRIV_RW_USER_RO);
+            ((unsigned int *)table)[j] = l2[j];
+            page_get(l2[j] & ~(PAGE_SIZE - 1));
+            shared++;
+        }
+        dst[i] = table | COARSE_DESCRIPTOR;
+    }
+    dsb();
+    spin_unlock_irqrestore(&pgtable_lock, flags);
+    return shared;
+}
+
+// Second-level entry for va, or 0 if va is not covered by a coarse table
+unsigned int *lookup_pte(unsigned int *l1, unsigned int va) {
+    unsigned int desc = l1[va >> 20];
+
+    if ((desc & 3) != COARSE_DESCRIPTOR)
+        return 0;
+    return (unsigned int *)(desc & COARSE_ADDR_MASK) + ((va >> PAGE_SHIFT) & (L2_ENTRIES - 1));
+}
+
+// Map one 4 KB page. The second-level table for the containing MB is only
+// allocated the first time something in that MB is mapped.
+int map_page(unsigned int *l1, unsigned int va, unsigned int pa, unsigned int attrs) {
+    unsigned int idx = va >> 20;
+    unsigned int flags = spin_lock_irqsave(&pgtable_lock);
+
+    if ((l1[idx] & 3) == 0) {
+        unsigned int table = alloc_l2_table();
+        if (!table) {
+            spin_unlock_irqrestore(&pgtable_lock, flags);
+            return -1;
+        }
+        l1[idx] = table | COARSE_DESCRIPTOR;
+    } else if ((l1[idx] & 3) != COARSE_DESCRIPTOR || (*lookup_pte(l1, va) & 3) == LARGE_PAGE) {
+        spin_unlock_irqrestore(&pgtable_lock, flags);
+        return -1;  // Covered by a (super)section or large page
+    }
+
+    *lookup_pte(l1, va) = (pa & ~(PAGE_SIZE - 1)) | attrs | SMALL_PAGE;
+    dsb();
+    asm volatile("mcr p15, 0, %0, c8, c3, 3" :: "r"(va & ~(PAGE_SIZE - 1)));   // TLBIMVAAIS
+    dsb();
+    isb();
+    spin_unlock_irqrestore(&pgtable_lock, flags);
+    return 0;
+}
+
+// Remove the mapping of one 4 KB page and return the frame it pointed at
+// (0 if nothing was mapped). The second-level table is kept for reuse.
+unsigned int unmap_page(unsigned int *l1, unsigned int va) {
+    unsigned int flags = spin_lock_irqsave(&pgtable_lock);
+    unsigned int *pte = lookup_pte(l1, va);
+    unsigned int pa = 0;
+
+    if (pte && (*pte & SMALL_PAGE)) {
+        pa = *pte & ~(PAGE_SIZE - 1);
+        *pte = 0;
+        dsb();
+        asm volatile("mcr p15, 0, %0, c8, c3, 3" :: "r"(va & ~(PAGE_SIZE - 1)));   // TLBIMVAAIS
+        dsb();
+        isb();
+    }
+    spin_unlock_irqrestore(&pgtable_lock, flags);
+    return pa;
+}
+
+// Replace the supersection covering va by 16 sections with the same
+// attributes, so that one MB of it can then be changed on its own. A single
+// TLBIMVAA anywhere in the supersection drops its TLB entry.
+void split_supersection(unsigned int *l1, unsigned int va) {
+    unsigned int first = (va >> 20) & ~(SUPERSECTION_ENTRIES - 1);
+    unsigned int flags = spin_lock_irqsave(&pgtable_lock);
+    unsigned int desc = l1[first];
+
+    if ((desc & 3) == SECTION_DESCRIPTOR && (desc & SUPERSECTION)) {
+        // Bits 23:20 hold the extended base address in a supersection
+        desc &= ~(SECTION_ADDR_MASK | SUPERSECTION);
+        for (unsigned int i = 0; i < SUPERSECTION_ENTRIES; i++)
+            l1[first + i] = ((first + i) << 20) | desc;
+        dsb();
+        asm volatile("mcr p15, 0, %0, c8, c3, 3" :: "r"(first << 20));     // TLBIMVAAIS
+        dsb();
+        isb();
+    }
+    spin_unlock_irqrestore(&pgtable_lock, flags);
+}
+
+// Inverse of split_supersection: if the 16 MB around va is 16 identically
+// attributed sections mapping a contiguous, aligned range, use one
+// supersection instead. Returns 0 on success.
+int merge_supersection(unsigned int *l1, unsigned int va) {
+    unsigned int first = (va >> 20) & ~(SUPERSECTION_ENTRIES - 1);
+    unsigned int flags = spin_lock_irqsave(&pgtable_lock);
+    unsigned int desc = l1[first];
+
+    if ((desc & 3) != SECTION_DESCRIPTOR || (desc & SUPERSECTION) ||
+        (desc & SECTION_ADDR_MASK & ~SUPERSECTION_ADDR_MASK)) {
+        spin_unlock_irqrestore(&pgtable_lock, flags);
+        return -1;
+    }
+    for (unsigned int i = 1; i < SUPERSECTION_ENTRIES; i++) {
+        if (l1[first + i] != desc + (i << 20)) {
+            spin_unlock_irqrestore(&pgtable_lock, flags);
+            return -1;
+        }
+    }
+
+    for (unsigned int i = 0; i < SUPERSECTION_ENTRIES; i++)
+        l1[first + i] = desc | SUPERSECTION;
+    dsb();
+    // Each old section may have its own TLB entry
+    for (unsigned int i = 0; i < SUPERSECTION_ENTRIES; i++)
+        asm volatile("mcr p15, 0, %0, c8, c3, 3" :: "r"((first + i) << 20));   // TLBIMVAAIS
+    dsb();
+    isb();
+    spin_unlock_irqrestore(&pgtable_lock, flags);
+    return 0;
+}
+
+// The first-level table this core is translating through
+static unsigned int *active_l1(void) {
+    unsigned int ttbr0;
+
+    asm volatile("mrc p15, 0, %0, c2, c0, 0" : "=r"(ttbr0));
+    return (unsigned int *)(ttbr0 & ~(L1_TABLE_ALIGN - 1));
+}
+
+// Check that EL0 may access [addr, addr + len) according to the current
+// process's tables, so syscalls can use user pointers directly without
+// copying them first. Demand-zero and copy-on-write pages in the range are
+// faulted in here, so the kernel never takes an abort on them.
+int user_range_ok(unsigned int addr, unsigned int len, int write) {
+    unsigned int *ttb = active_l1();
+    unsigned int end, next, desc, ap;
+    unsigned int va = addr;
+
+    if (len == 0)
+        return 1;
+    if (addr + len < addr)
+        return 0;
+
+    end = addr + len - 1;
+    while (1) {
+        desc = ttb[va >> 20];
+        if ((desc & 3) == SECTION_DESCRIPTOR) {
+            ap = (desc >> 10) & 3;
+            if (desc & SUPERSECTION)
+                next = (va & SUPERSECTION_ADDR_MASK) + (SUPERSECTION_ENTRIES << 20);
+            else
+                next = (va & SECTION_ADDR_MASK) + (1 << 20);
+        } else if ((desc & 3) == COARSE_DESCRIPTOR) {
+            unsigned int pte = *lookup_pte(ttb, va);
+            if (pte & SMALL_PAGE)
+                next = (va & ~(PAGE_SIZE - 1)) + PAGE_SIZE;
+            else if ((pte & 3) == LARGE_PAGE)
+                next = (va & ~(LARGE_PAGE_SIZE - 1)) + LARGE_PAGE_SIZE;
+            else if (handle_user_fault(va, write ? FAULT_WRITE : 0) == 0)
+                continue;
+            else
+                return 0;
+            ap = (pte >> 4) & 3;
+        } else if (handle_user_fault(va, write ? FAULT_WRITE : 0) == 0) {
+            continue;
+        } else {
+            return 0;
+        }
+
+        if (write && ap == AP_PRIV_RW_USER_RO && handle_user_fault(va, write ? FAULT_WRITE : 0) == 0)
+            continue;
+        if (ap != AP_PRIV_RW_USER_RW && (write || ap != AP_PRIV_RW_USER_RO))
+            return 0;
+        if (next - 1 >= end)
+            return 1;
+        va = next;
+    }
+}
@@ -1,11 +1,5 @@
 #include "utils.h"
 
-void delay(unsigned int count) {
-    for (unsigned int i = 0; i < count; i++) {
-        asm volatile("nop");
-    }
-}
-
 void put32(unsigned int addr, unsigned int value) {
     *(volatile unsigned int*)addr = value;
 }
@@ -13,3 +7,19 @@ void put32(unsigned int addr, unsigned int value) {
 unsigned int get32(unsigned int addr) {
     return *(volatile unsigned int*)addr;
 }
+
+// Shift-subtract division: the kernel links without libgcc's __aeabi_uldivmod
+unsigned long long udiv64(unsigned long long n, unsigned int d) {
+    unsigned long long q = 0, r = 0;
+
+    for (int i = 0; i < 64; i++) {
+        r = (r << 1) | (n >> 63);
+        n <<= 1;
+        q <<= 1;
+        if (r >= d) {
+            r -= d;
+            q |= 1;
+        }
+    }
+    return q;
+}
@@ -0,0 +1,61 @@
+"""
+Pack the EL0 programs into the kernel's initramfs (see include/exec.h):
+a header, one entry per file, then every file starting on a page boundary
+so the kernel can map its read-only pages without copying them.
+
+Usage:
+  python3 tools/mkinitramfs.py -o build/initramfs.img build/user/*.elf
+
+Each file is entered under its base name without the extension.
+"""
+import argparse
+import os
+import struct
+import sys
+
+INITRAMFS_MAGIC = 0x53465249
+INITRAMFS_NAME_MAX = 24
+INITRAMFS_MAX = 16
+PAGE_SIZE = 4096
+
+HEADER = struct.Struct("<II")
+ENTRY = struct.Struct("<%dsII" % INITRAMFS_NAME_MAX)
+
+
+def align(n):
+    return (n + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    ap.add_argument("files", nargs="+")
+    ap.add_argument("-o", "--output", required=True)
+    args = ap.parse_args()
+
+    if len(args.files) > INITRAMFS_MAX:
+        sys.exit("mkinitramfs: at most %d files" % INITRAMFS_MAX)
+
+    entries, blobs = [], []
+    offset = align(HEADER.size + ENTRY.size * len(args.files))
+    for path in args.files:
+        name = os.path.splitext(os.path.basename(path))[0].encode()
+        if len(name) >= INITRAMFS_NAME_MAX:
+            sys.exit("mkinitramfs: name too long: %s" % path)
+        with open(path, "rb") as f:
+            data = f.read()
+        entries.append(ENTRY.pack(name, offset, len(data)))
+        blobs.append((offset, data))
+        offset = align(offset + len(data))
+
+    out = bytearray(offset)
+    HEADER.pack_into(out, 0, INITRAMFS_MAGIC, len(entries))
+    for i, e in enumerate(entries):
+        out[HEADER.size + i * ENTRY.size:HEADER.size + (i + 1) * ENTRY.size] = e
+    for off, data in blobs:
+        out[off:off + len(data)] = data
+    with open(args.output, "wb") as f:
+        f.write(out)
+
+
+if __name__ == "__main__":
+    main()
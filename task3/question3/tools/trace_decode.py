@@ -0,0 +1,267 @@
+"""
+Decode a TRACE=1 kernel's binary trace dump (see include/trace.h) into
+Chrome-trace JSON, loadable in chrome://tracing or ui.perfetto.dev, and
+print per-path latency histograms.
+
+Usage:
+  python3 tools/trace_decode.py build/serial.bin -o trace.json
+
+The input is the raw serial capture; console text around the dump is
+skipped. With several dumps in one capture the last complete one is used.
+"""
+import argparse
+import json
+import struct
+import sys
+
+TRACE_MAGIC = 0x43525449
+TRACE_MAGIC_END = 0x45525449
+TRACE_VERSION = 1
+
+TRACE_SYSCALL_ENTER = 1
+TRACE_SYSCALL_EXIT = 2
+TRACE_IRQ_ENTER = 3
+TRACE_IRQ_EXIT = 4
+TRACE_SWITCH = 5
+TRACE_FAULT = 6
+TRACE_MARK = 7
+
+HEADER = struct.Struct("<IHHIH4BH")
+CPU_HEADER = struct.Struct("<III4I")
+EVENT = struct.Struct("<IIIBBH")
+
+# include/syscall.h
+SYSCALL_NAMES = {
+    0: "null", 1: "exit", 2: "fork", 3: "read", 4: "write", 11: "execve",
+    20: "getpid", 146: "writev", 158: "sched_yield", 159: "trace_ctl",
+    160: "chan_create", 161: "chan_map", 162: "chan_send", 163: "chan_recv",
+    168: "poll", 240: "futex",
+}
+
+PMU_EVENT_NAMES = {
+    0x03: "l1d_refill", 0x05: "l1d_tlb_refill",
+    0x08: "inst_retired", 0x10: "br_mis_pred",
+}
+
+# CORE_IRQ_SOURCE bits (include/peripherals/irq.h)
+IRQ_SOURCE_NAMES = {3: "timer", 4: "ipi", 8: "gpu"}
+
+
+def find_dump(data):
+    """Return (offset, end) of the last complete dump in the capture."""
+    magic = struct.pack("<I", TRACE_MAGIC)
+    pos = data.rfind(magic)
+    while pos >= 0:
+        end = parse_length(data, pos)
+        if end is not None:
+            return pos, end
+        pos = data.rfind(magic, 0, pos)
+    return None
+
+
+def parse_length(data, pos):
+    """Walk the frame at pos; return its end offset, or None if it is cut short."""
+    if pos + HEADER.size > len(data):
+        return None
+    fields = HEADER.unpack_from(data, pos)
+    ncpus, event_size = fields[2], fields[4]
+    if fields[1] != TRACE_VERSION or event_size != EVENT.size:
+        return None
+    off = pos + HEADER.size
+    for _ in range(ncpus):
+        if off + CPU_HEADER.size > len(data):
+            return None
+        count = CPU_HEADER.unpack_from(data, off)[1]
+        off += CPU_HEADER.size + count * event_size
+    if off + 4 > len(data) or struct.unpack_from("<I", data, off)[0] != TRACE_MAGIC_END:
+        return None
+    return off + 4
+
+
+def parse(data, pos):
+    fields = HEADER.unpack_from(data, pos)
+    header = {
+        "ncpus": fields[2],
+        "timer_hz": fields[3],
+        "pmu_events": list(fields[5:9]),
+    }
+    off = pos + HEADER.size
+    cpus = []
+    for _ in range(header["ncpus"]):
+        cpu, count, lost, *pmu = CPU_HEADER.unpack_from(data, off)
+        off += CPU_HEADER.size
+        events = []
+        for _ in range(count):
+            cycles, ts, arg, typ, ecpu, pid = EVENT.unpack_from(data, off)
+            off += EVENT.size
+            events.append({"cycles": cycles, "ts": ts, "arg": arg,
+                           "type": typ, "cpu": ecpu, "pid": pid})
+        cpus.append({"cpu": cpu, "lost": lost, "pmu": pmu, "events": events})
+    return header, cpus
+
+
+def unwrap(cpus):
+    """Extend each core's 32-bit timer stamps to 64 bits and rebase on the earliest."""
+    for c in cpus:
+        high, last = 0, None
+        for e in c["events"]:
+            if last is not None and e["ts"] < last:
+                high += 1 << 32
+            last = e["ts"]
+            e["t"] = high + e["ts"]
+    firsts = [c["events"][0]["t"] for c in cpus if c["events"]]
+    base = min(firsts) if firsts else 0
+    for c in cpus:
+        for e in c["events"]:
+            e["t"] -= base
+
+
+def syscall_name(nr):
+    return "sys_" + SYSCALL_NAMES.get(nr, str(nr))
+
+
+def irq_name(source):
+    names = [n for bit, n in IRQ_SOURCE_NAMES.items() if source & (1 << bit)]
+    return "irq " + ("+".join(names) if names else hex(source))
+
+
+def task_name(pid):
+    return "idle" if pid == 0 else "task %d" % pid
+
+
+def build(header, cpus):
+    """Return (chrome trace dict, {path: [latency in cycles]}, migrated count)."""
+    us = 1e6 / header["timer_hz"]
+    out = []
+    latencies = {}
+    migrated = 0
+
+    def add_latency(path, enter, exit_):
+        nonlocal migrated
+        if enter["cpu"] != exit_["cpu"]:
+            migrated += 1   # Cycle counters are per core
+            return
+        latencies.setdefault(path, []).append((exit_["cycles"] - enter["cycles"]) & 0xFFFFFFFF)
+
+    def complete(pid, tid, name, start, end, args):
+        out.append({"ph": "X", "pid": pid, "tid": tid, "name": name,
+                    "ts": start["t"] * us, "dur": (end["t"] - start["t"]) * us, "args": args})
+
+    out.append({"ph": "M", "pid": 0, "name": "process_name", "args": {"name": "cores"}})
+    out.append({"ph": "M", "pid": 1, "name": "process_name", "args": {"name": "tasks"}})
+
+    tasks = set()
+
+    for c in cpus:
+        cpu = c["cpu"]
+        out.append({"ph": "M", "pid": 0, "tid": cpu, "name": "thread_name",
+                    "args": {"name": "cpu %d" % cpu}})
+        out.append({"ph": "M", "pid": 0, "tid": 100 + cpu, "name": "thread_name",
+                    "args": {"name": "cpu %d irq" % cpu}})
+        running = None
+        irq_stack = []
+
+        for e in c["events"]:
+            tasks.add(e["pid"])
+            if running is None:
+                running = e
+            if e["type"] == TRACE_SWITCH:
+                complete(0, cpu, task_name(running["pid"]), running, e, {})
+                running = dict(e, pid=e["arg"])
+            elif e["type"] == TRACE_IRQ_ENTER:
+                irq_stack.append(e)
+            elif e["type"] == TRACE_IRQ_EXIT and irq_stack:
+                enter = irq_stack.pop()
+                name = irq_name(enter["arg"])
+                complete(0, 100 + cpu, name, enter, e, {})
+                add_latency(name, enter, e)
+            elif e["type"] in (TRACE_FAULT, TRACE_MARK):
+                name = "fault" if e["type"] == TRACE_FAULT else "mark"
+                out.append({"ph": "i", "s": "t", "pid": 1, "tid": e["pid"], "name": name,
+                            "ts": e["t"] * us, "args": {"arg": hex(e["arg"]), "cpu": cpu}})
+
+        if running is not None and c["events"]:
+            complete(0, cpu, task_name(running["pid"]), running, c["events"][-1], {})
+
+    # Syscalls pair up per task across all cores in time order: a task may
+    # block on one core and return on another, lower- or higher-numbered
+    open_syscalls = {}
+    merged = sorted((e for c in cpus for e in c["events"]
+                     if e["type"] in (TRACE_SYSCALL_ENTER, TRACE_SYSCALL_EXIT)),
+                    key=lambda e: (e["t"], e["type"] == TRACE_SYSCALL_EXIT))
+    for e in merged:
+        if e["type"] == TRACE_SYSCALL_ENTER:
+            open_syscalls.setdefault(e["pid"], []).append(e)
+        elif open_syscalls.get(e["pid"]):
+            enter = open_syscalls[e["pid"]].pop()
+            name = syscall_name(enter["arg"])
+            complete(1, e["pid"], name, enter, e,
+                     {"cpu_enter": enter["cpu"], "cpu_exit": e["cpu"]})
+            add_latency(name, enter, e)
+
+    for pid in sorted(tasks):
+        out.append({"ph": "M", "pid": 1, "tid": pid, "name": "thread_name",
+                    "args": {"name": task_name(pid)}})
+
+    meta = {
+        "timer_hz": header["timer_hz"],
+        "cpus": [{"cpu": c["cpu"], "records": len(c["events"]), "lost": c["lost"],
+                  "pmu": {PMU_EVENT_NAMES.get(ev, hex(ev)): v
+                          for ev, v in zip(header["pmu_events"], c["pmu"])}}
+                 for c in cpus],
+    }
+    return {"traceEvents": out, "displayTimeUnit": "ns", "otherData": meta}, latencies, migrated
+
+
+def percentile(sorted_values, p):
+    return sorted_values[min(len(sorted_values) - 1, int(len(sorted_values) * p / 100))]
+
+
+def print_histograms(latencies, migrated, file=sys.stdout):
+    """Power-of-two buckets of cycles per path, widest bar 40 characters."""
+    for path in sorted(latencies):
+        values = sorted(latencies[path])
+        print("%s: n=%d min=%d p50=%d p99=%d max=%d cycles" % (
+            path, len(values), values[0], percentile(values, 50),
+            percentile(values, 99), values[-1]), file=file)
+        buckets = {}
+        for v in values:
+            buckets[v.bit_length()] = buckets.get(v.bit_length(), 0) + 1
+        peak = max(buckets.values())
+        for bits in range(min(buckets), max(buckets) + 1):
+            n = buckets.get(bits, 0)
+            low = 0 if bits == 0 else 1 << (bits - 1)
+            high = (1 << bits) - 1
+            print("  %9d-%-9d |%-40s %d" % (low, high, "#" * ((n * 40 + peak - 1) // peak), n), file=file)
+    if migrated:
+        print("%d enter/exit pairs crossed cores and are left out" % migrated, file=file)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().split("\n")[0])
+    parser.add_argument("capture", help="raw serial output containing a trace dump")
+    parser.add_argument("-o", "--output", default="trace.json", help="Chrome-trace JSON file")
+    args = parser.parse_args()
+
+    with open(args.capture, "rb") as f:
+        data = f.read()
+    found = find_dump(data)
+    if found is None:
+        sys.exit("%s: no complete trace dump found" % args.capture)
+
+    header, cpus = parse(data, found[0])
+    unwrap(cpus)
+    trace, latencies, migrated = build(header, cpus)
+    with open(args.output, "w") as f:
+        json.dump(trace, f)
+
+    for c in trace["otherData"]["cpus"]:
+        print("cpu %d: %d records, %d lost, %s" % (
+            c["cpu"], c["records"], c["lost"],
+            " ".join("%s=%d" % kv for kv in c["pmu"].items())))
+    print_histograms(latencies, migrated)
+    print("wrote %s" % args.output)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,7 @@
+#include "syscall.h"
+
+// Replaces itself with true, for bench_exec's execve timing
+int main(void) {
+    execve("true");
+    return -1;
+}
@@ -0,0 +1,18 @@
+#include "syscall.h"
+
+// The syscall demo: one write, then three buffers in one writev
+int main(void) {
+    static const char hello[] = "Hello from EL0 via write()\r\n";
+    static const char tag[] = "EL0: ";
+    static const char body[] = "three buffers, one trap";
+    static const char eol[] = "\r\n";
+    struct iovec iov[3] = {
+        { tag, sizeof(tag) - 1 },
+        { body, sizeof(body) - 1 },
+        { eol, sizeof(eol) - 1 },
+    };
+
+    write(STDOUT_FILENO, hello, sizeof(hello) - 1);
+    writev(STDOUT_FILENO, iov, 3);
+    return 0;
+}
@@ -0,0 +1,13 @@
+#include "syscall.h"
+
+static volatile int counter = 1;
+static volatile char scratch[4096];
+
+// Touches one data page, one bss page and its stack, then sleeps for good,
+// so bench_exec can count what each extra instance costs
+int main(void) {
+    counter++;
+    scratch[0] = 1;
+    while (1)
+        poll(0, 0, -1);
+}
@@ -0,0 +1,18 @@
+#include "syscall.h"
+
+// Busy-loop iterations between lines
+#define TICKER_SPIN     2000000
+
+// Preemption demo: several copies print their pid and spin, never yielding,
+// so their lines only interleave because the timer switches tasks
+int main(void) {
+    char msg[] = "task 00: tick\r\n";
+    int pid = getpid();
+
+    msg[5] = '0' + pid / 10;
+    msg[6] = '0' + pid % 10;
+    while (1) {
+        write(STDOUT_FILENO, msg, sizeof(msg) - 1);
+        for (volatile unsigned int i = 0; i < TICKER_SPIN; i++);
+    }
+}
@@ -0,0 +1,13 @@
+#include "syscall.h"
+#include "trace.h"
+
+// Busy-loop iterations the other tasks get before the dump
+#define TRACEDUMP_SPIN  8000000
+
+// TRACE=1 builds: let the other tasks run for a few ticker lines, then
+// dump the trace
+int main(void) {
+    for (volatile unsigned int i = 0; i < TRACEDUMP_SPIN; i++);
+    trace_ctl(TRACE_CTL_DUMP, 0);
+    return 0;
+}